@@ -0,0 +1,427 @@
+#include <vee/libtest.h>
+#include <vee/lock.h>
+#include <vee/lock_profile.h>
+#include <vee/delegate.h>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+namespace vee {
+
+namespace libtest {
+
+namespace {
+
+// Every field holds the same value, so a torn copy is visible to the reader
+struct snapshot_t
+{
+    uint64_t fields[6];
+    bool consistent() const
+    {
+        for (auto& it : fields)
+        {
+            if (it != fields[0])
+                return false;
+        }
+        return true;
+    }
+};
+
+// Each writer increases every field by one per write, so lost updates show up in the final value
+template <class SeqlockTy>
+size_t test_seqlock_consistency(size_t readers, size_t writers, size_t writes)
+{
+    SeqlockTy lock;
+    std::atomic<size_t> writers_done{ 0 };
+    std::atomic<bool> torn{ false };
+    std::atomic<bool> backwards{ false };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < writers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t n = 0; n < writes; ++n)
+            {
+                lock.write([](snapshot_t& data)
+                {
+                    for (auto& it : data.fields)
+                        ++it;
+                });
+            }
+            writers_done.fetch_add(1);
+        });
+    }
+    for (size_t i = 0; i < readers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            uint64_t last = 0;
+            do
+            {
+                snapshot_t snapshot = lock.load();
+                if (!snapshot.consistent())
+                    torn.store(true);
+                if (snapshot.fields[0] < last)
+                    backwards.store(true);
+                last = snapshot.fields[0];
+            } while (writers_done.load() != writers);
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+    snapshot_t result = lock.load();
+    bool success = (!torn.load() && !backwards.load() && result.consistent() && result.fields[0] == writers * writes);
+    success &= (lock.sequence() == writers * writes * 2);
+    test_log(success, __FUNCTION__, "readers: %u, writers: %u, writes: %u", (unsigned)readers, (unsigned)writers, (unsigned)writes);
+    return (success) ? 0 : 1;
+}
+
+// A throwing update must still end the write, otherwise the next reader spins forever
+size_t test_seqlock_throwing_write()
+{
+    lock::seqlock<snapshot_t> lock;
+    bool thrown = false;
+    try
+    {
+        lock.write([](snapshot_t& data)
+        {
+            data.fields[0] = 1;
+            throw std::runtime_error("update failed");
+        });
+    }
+    catch (std::runtime_error&)
+    {
+        thrown = true;
+    }
+    snapshot_t out;
+    bool success = (thrown && lock.try_load(out) && lock.sequence() == 2);
+    test_log(success, __FUNCTION__, "sequence: %u", (unsigned)lock.sequence());
+    return (success) ? 0 : 1;
+}
+
+// A plain counter behind the lock, a lost increment means two owners at once
+template <class LockTy>
+size_t test_lock_exclusion(size_t threads, size_t iterations)
+{
+    LockTy lock;
+    size_t counter = 0;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t n = 0; n < iterations; ++n)
+            {
+                std::lock_guard<LockTy> locker{ lock };
+                ++counter;
+            }
+        });
+    }
+    for (auto& it : workers)
+        it.join();
+    bool success = (counter == threads * iterations);
+    test_log(success, __FUNCTION__, "threads: %u, iterations: %u, counter: %u", (unsigned)threads, (unsigned)iterations, (unsigned)counter);
+    return (success) ? 0 : 1;
+}
+
+// try_lock reports the acquisition, not the previous state
+template <class LockTy>
+size_t test_lock_try_lock()
+{
+    LockTy lock;
+    bool success = lock.try_lock();
+    success &= !lock.try_lock();
+    lock.unlock();
+    success &= lock.try_lock();
+    lock.unlock();
+    test_log(success, __FUNCTION__, "");
+    return (success) ? 0 : 1;
+}
+
+// The owner holds the lock long enough for the waiters to give up spinning and park, the unlock must wake them
+template <class LockTy>
+size_t test_lock_parking(size_t waiters)
+{
+    LockTy lock;
+    std::atomic<size_t> acquired{ 0 };
+    lock.lock();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < waiters; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            std::lock_guard<LockTy> locker{ lock };
+            acquired.fetch_add(1);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool success = (acquired.load() == 0);
+    lock.unlock();
+    for (auto& it : threads)
+        it.join();
+    success &= (acquired.load() == waiters && lock.try_lock());
+    test_log(success, __FUNCTION__, "waiters: %u", (unsigned)waiters);
+    return (success) ? 0 : 1;
+}
+
+// A thread holds two mcs_locks at once and releases them out of order, each must keep its own node
+size_t test_mcs_lock_nesting()
+{
+    lock::mcs_lock first, second;
+    size_t counter = 0;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t n = 0; n < 20000; ++n)
+            {
+                first.lock();
+                second.lock();
+                ++counter;
+                first.unlock();
+                second.unlock();
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+    bool success = (counter == 4 * 20000 && first.try_lock() && second.try_lock());
+    first.unlock();
+    second.unlock();
+    test_log(success, __FUNCTION__, "counter: %u", (unsigned)counter);
+    return (success) ? 0 : 1;
+}
+
+// Four nodes, and every call moves the thread to the next one, as if it migrated between every lock and unlock
+struct migrating_topology
+{
+    static size_t node_count()
+    {
+        return 4;
+    }
+    static size_t current_node()
+    {
+        static thread_local size_t calls = 0;
+        return calls++ % 4;
+    }
+};
+
+// The system topology must be consistent, and the cohorts of a multi-node lock must exclude each other
+size_t test_cohort_lock_topology(size_t threads, size_t iterations)
+{
+    const size_t nodes = lock::numa::node_count();
+    const size_t current = lock::numa::current_node();
+    bool success = (nodes >= 1 && current < nodes);
+    test_log(success, __FUNCTION__, "nodes: %u, current node: %u", (unsigned)nodes, (unsigned)current);
+    return ((success) ? 0 : 1) + test_lock_exclusion<lock::basic_cohort_lock<migrating_topology>>(threads, iterations);
+}
+
+// A shared owner lets other readers in and keeps the writers out
+size_t test_shared_spin_lock_sharing()
+{
+    lock::shared_spin_lock lock;
+    lock.lock_shared();
+    bool success = true;
+    std::thread other([&]()
+    {
+        success &= lock.try_lock_shared();
+        lock.unlock_shared();
+        success &= !lock.try_lock();
+    });
+    other.join();
+    success &= !lock.try_lock();
+    lock.unlock_shared();
+    success &= lock.try_lock();
+    success &= !lock.try_lock_shared();
+    lock.unlock();
+    test_log(success, __FUNCTION__, "");
+    return (success) ? 0 : 1;
+}
+
+// The writers keep two fields equal, a reader must never see them apart
+size_t test_shared_spin_lock_consistency(size_t readers, size_t writers, size_t writes)
+{
+    lock::shared_spin_lock lock;
+    uint64_t first = 0, second = 0;
+    std::atomic<size_t> writers_done{ 0 };
+    std::atomic<bool> torn{ false };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < writers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t n = 0; n < writes; ++n)
+            {
+                std::lock_guard<lock::shared_spin_lock> locker{ lock };
+                ++first;
+                ++second;
+            }
+            writers_done.fetch_add(1);
+        });
+    }
+    for (size_t i = 0; i < readers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            do
+            {
+                lock::shared_guard<lock::shared_spin_lock> locker{ lock };
+                if (first != second)
+                    torn.store(true);
+            } while (writers_done.load() != writers);
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+    bool success = (!torn.load() && first == writers * writes && second == first);
+    test_log(success, __FUNCTION__, "readers: %u, writers: %u, writes: %u", (unsigned)readers, (unsigned)writers, (unsigned)writes);
+    return (success) ? 0 : 1;
+}
+
+// Several threads fire one event while another one registers and removes handlers
+size_t test_delegate_shared_invocation()
+{
+    static_assert(lock::is_shared_lockable<lock::shared_spin_lock>::value, "shared_spin_lock must be detected as shared-lockable");
+    static_assert(!lock::is_shared_lockable<lock::spin_lock>::value, "spin_lock must not be detected as shared-lockable");
+    delegate<void(), lock::shared_spin_lock> event;
+    std::atomic<size_t> calls{ 0 };
+    event += std::make_pair(0, [&calls]() { calls.fetch_add(1); });
+    const size_t firers = 4, fires = 20000;
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < firers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t n = 0; n < fires; ++n)
+                event();
+        });
+    }
+    size_t changes = 0;
+    std::thread registrar([&]()
+    {
+        while (!done.load())
+        {
+            event += std::make_pair(1, []() {});
+            event -= delegate<void(), lock::shared_spin_lock>::usrkey(1);
+            ++changes;
+        }
+    });
+    for (auto& it : threads)
+        it.join();
+    done.store(true);
+    registrar.join();
+    bool success = (calls.load() == firers * fires && !event.empty());
+    test_log(success, __FUNCTION__, "calls: %u, registrations: %u", (unsigned)calls.load(), (unsigned)changes);
+    return (success) ? 0 : 1;
+}
+
+const lock::profile_snapshot* find_profile(const std::vector<lock::profile_snapshot>& entries, const char* name)
+{
+    for (auto& it : entries)
+    {
+        if (it.name == name)
+            return &it;
+    }
+    return nullptr;
+}
+
+uint64_t total_samples(const lock::histogram::counts_t& counts)
+{
+    uint64_t total = 0;
+    for (auto it : counts)
+        total += it;
+    return total;
+}
+
+// Two locks under one name, one of them destroyed before the collection, must add up to every acquisition
+size_t test_profiled_lock(size_t threads, size_t iterations)
+{
+    const char* name = "libtest.test_profiled_lock";
+    lock::profiled<lock::spin_lock> survivor{ name };
+    {
+        lock::profiled<lock::spin_lock> temporary{ name };
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([&]()
+            {
+                for (size_t n = 0; n < iterations; ++n)
+                {
+                    std::lock_guard<lock::profiled<lock::spin_lock>> first{ temporary };
+                    std::lock_guard<lock::profiled<lock::spin_lock>> second{ survivor };
+                }
+            });
+        }
+        for (auto& it : workers)
+            it.join();
+    }
+    const auto entries = lock::profile_registry::instance().collect();
+    const lock::profile_snapshot* entry = find_profile(entries, name);
+    const uint64_t expected = threads * iterations * 2;
+    bool success = (entry != nullptr && entry->locks == 2 && entry->acquisitions == expected && entry->contended <= expected);
+    success &= (entry != nullptr && total_samples(entry->hold) == expected && total_samples(entry->wait) == entry->contended);
+    test_log(success, __FUNCTION__, "threads: %u, iterations: %u, acquisitions: %u, contended: %u",
+             (unsigned)threads, (unsigned)iterations,
+             (unsigned)(entry ? entry->acquisitions : 0), (unsigned)(entry ? entry->contended : 0));
+    return (success) ? 0 : 1;
+}
+
+// The percentile reports the upper bound of the bucket, the shared interface follows the wrapped lock
+size_t test_profile_histogram()
+{
+    static_assert(lock::is_shared_lockable<lock::profiled<lock::shared_spin_lock>>::value, "profiled must forward the shared interface");
+    static_assert(!lock::is_shared_lockable<lock::profiled<lock::spin_lock>>::value, "profiled must not invent a shared interface");
+    lock::histogram::counts_t counts{};
+    counts[lock::histogram::bucket_of(100)] += 98;    // [64, 128)
+    counts[lock::histogram::bucket_of(5000)] += 2;    // [4096, 8192)
+    bool success = (lock::histogram::bucket_of(0) == 0 && lock::histogram::bucket_of(1) == 1 && lock::histogram::bucket_of(127) == 7);
+    success &= (lock::histogram::percentile(counts, 0.5) == 127 && lock::histogram::percentile(counts, 1.0) == 8191);
+    test_log(success, __FUNCTION__, "p50: %u, max: %u", (unsigned)lock::histogram::percentile(counts, 0.5), (unsigned)lock::histogram::percentile(counts, 1.0));
+    return (success) ? 0 : 1;
+}
+
+} // !unnamed namespace
+
+size_t test_lock::test_all() noexcept
+{
+    size_t error = 0;
+    error += test_seqlock_consistency<lock::seqlock<snapshot_t>>(4, 1, 100000);
+    error += test_seqlock_consistency<lock::multi_writer_seqlock<snapshot_t>>(4, 4, 50000);
+    error += test_seqlock_consistency<lock::multi_writer_seqlock<snapshot_t>>(0, 8, 20000);
+    error += test_seqlock_throwing_write();
+    error += test_lock_try_lock<lock::spin_lock>();
+    error += test_lock_exclusion<lock::spin_lock>(8, 100000);
+    error += test_lock_parking<lock::spin_lock>(4);
+    error += test_lock_try_lock<lock::ticket_lock>();
+    error += test_lock_exclusion<lock::ticket_lock>(8, 20000);
+    error += test_lock_parking<lock::ticket_lock>(4);
+    error += test_lock_try_lock<lock::mcs_lock>();
+    error += test_lock_exclusion<lock::mcs_lock>(8, 20000);
+    error += test_lock_parking<lock::mcs_lock>(4);
+    error += test_mcs_lock_nesting();
+    error += test_lock_try_lock<lock::cohort_lock>();
+    error += test_lock_exclusion<lock::cohort_lock>(8, 20000);
+    error += test_lock_parking<lock::cohort_lock>(4);
+    error += test_cohort_lock_topology(8, 20000);
+    error += test_lock_try_lock<lock::shared_spin_lock>();
+    error += test_lock_exclusion<lock::shared_spin_lock>(8, 100000);
+    error += test_lock_parking<lock::shared_spin_lock>(4);
+    error += test_shared_spin_lock_sharing();
+    error += test_shared_spin_lock_consistency(4, 2, 50000);
+    error += test_delegate_shared_invocation();
+    error += test_profiled_lock(4, 20000);
+    error += test_profile_histogram();
+
+    return error;
+}
+
+} // !namespace libtest
+
+} // !namespace vee
@@ -0,0 +1,1388 @@
+#include <vee/libtest.h>
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/stack.h>
+#include <vee/lockfree/unbounded_queue.h>
+#include <vee/lockfree/work_stealing_deque.h>
+#include <vee/lockfree/mailbox.h>
+#include <vee/lockfree/blocking.h>
+#include <vee/lockfree/object_pool.h>
+#include <vee/lockfree/hash_map.h>
+#include <vee/lockfree/multicast_ring.h>
+#include <vee/queue.h>
+#include <vee/lockfree/ebr.h>
+#include <vee/lockfree/hazard_pointer.h>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace vee {
+
+namespace libtest {
+
+namespace {
+
+// The capacity may be rounded up by the layout policy of the queue
+template <class QueueTy>
+size_t test_fifo_order(size_t requested, size_t laps)
+{
+    QueueTy q{ requested };
+    const size_t capacity = q.capacity;
+    bool result = (capacity >= requested && capacity < requested * 2);
+    for (size_t lap = 0; lap < laps && result; ++lap)
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            result &= q.enqueue(lap * capacity + i);
+        size_t overflow = 0;
+        result &= !q.enqueue(overflow);
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            size_t out = 0;
+            result &= (q.dequeue(out) && out == lap * capacity + i);
+        }
+        size_t out = 0;
+        result &= !q.dequeue(out);
+    }
+    test_log(result, __FUNCTION__, "capacity: %u, laps: %u", (unsigned)capacity, (unsigned)laps);
+    return (result) ? 0 : 1;
+}
+
+template <class QueueTy>
+size_t test_bulk_fifo_order(size_t capacity, size_t chunk, size_t total)
+{
+    QueueTy q{ capacity };
+    std::vector<size_t> in(chunk), out(chunk);
+    size_t next_in = 0, next_out = 0;
+    bool result = true;
+    while (next_out < total && result)
+    {
+        for (size_t i = 0; i < chunk; ++i)
+            in[i] = next_in + i;
+        size_t pushed = q.enqueue_bulk(in.begin(), in.begin() + std::min(chunk, total - next_in));
+        result &= (pushed <= capacity);
+        next_in += pushed;
+        size_t popped = q.dequeue_bulk(out.begin(), chunk);
+        for (size_t i = 0; i < popped; ++i)
+            result &= (out[i] == next_out + i);
+        next_out += popped;
+        result &= (pushed != 0 || popped != 0);
+    }
+    size_t rest = 0;
+    result &= (q.dequeue_bulk(&rest, 1) == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, chunk: %u, items: %u", (unsigned)capacity, (unsigned)chunk, (unsigned)total);
+    return (result) ? 0 : 1;
+}
+
+template <class StackTy>
+size_t test_lifo_order(size_t capacity, size_t laps)
+{
+    StackTy s{ capacity };
+    bool result = true;
+    for (size_t lap = 0; lap < laps && result; ++lap)
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            result &= s.push(lap * capacity + i);
+        size_t overflow = 0;
+        result &= !s.push(overflow);
+        for (size_t i = capacity; i > 0; --i)
+        {
+            size_t out = 0;
+            result &= (s.pop(out) && out == lap * capacity + i - 1);
+        }
+        size_t out = 0;
+        result &= !s.pop(out);
+    }
+    test_log(result, __FUNCTION__, "capacity: %u, laps: %u", (unsigned)capacity, (unsigned)laps);
+    return (result) ? 0 : 1;
+}
+
+// Every thread pops an index and pushes it back, an index must never be held by two threads at once
+size_t test_index_stack_exclusive(size_t capacity, size_t threads, size_t rounds)
+{
+    lockfree::index_stack s{ capacity, true };
+    std::unique_ptr<std::atomic<int>[]> owners{ new std::atomic<int>[capacity] };
+    for (size_t i = 0; i < capacity; ++i)
+        owners[i].store(0);
+    std::atomic<size_t> conflicts{ 0 };
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&]()
+        {
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                lockfree::index_stack::index_t idx = 0;
+                if (!s.pop(idx))
+                    continue;
+                if (owners[idx].fetch_add(1) != 0)
+                    conflicts.fetch_add(1);
+                owners[idx].fetch_sub(1);
+                s.push(idx);
+            }
+        });
+    }
+    for (auto& it : pool)
+        it.join();
+    size_t remained = 0;
+    lockfree::index_stack::index_t idx = 0;
+    while (s.pop(idx))
+        ++remained;
+    bool result = (conflicts.load() == 0 && remained == capacity);
+    test_log(result, __FUNCTION__, "capacity: %u, threads: %u, rounds: %u", (unsigned)capacity, (unsigned)threads, (unsigned)rounds);
+    return (result) ? 0 : 1;
+}
+
+// pop_chain detaches the top indices in pop order, and the chains of the threads never share an index
+size_t test_index_stack_chains(size_t capacity, size_t threads, size_t rounds)
+{
+    typedef lockfree::index_stack::index_t index_t;
+    lockfree::index_stack s{ capacity, true };
+    index_t first[3] = {};
+    bool result = (s.pop_chain(first, 3) == 3 && first[0] == 0 && first[1] == 1 && first[2] == 2);
+    s.push_chain(first, 3);
+    std::unique_ptr<std::atomic<int>[]> owners{ new std::atomic<int>[capacity] };
+    for (size_t i = 0; i < capacity; ++i)
+        owners[i].store(0);
+    std::atomic<size_t> conflicts{ 0 };
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]()
+        {
+            index_t chain[4] = {};
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                const size_t count = s.pop_chain(chain, 1 + (i + t) % 4);
+                for (size_t n = 0; n < count; ++n)
+                {
+                    if (owners[chain[n]].fetch_add(1) != 0)
+                        conflicts.fetch_add(1);
+                }
+                for (size_t n = 0; n < count; ++n)
+                    owners[chain[n]].fetch_sub(1);
+                s.push_chain(chain, count);
+            }
+        });
+    }
+    for (auto& it : pool)
+        it.join();
+    std::vector<index_t> remained(capacity + 1);
+    const size_t count = s.pop_chain(remained.data(), capacity + 1);
+    std::sort(remained.begin(), remained.begin() + count);
+    result &= (conflicts.load() == 0 && count == capacity && s.empty());
+    for (size_t i = 0; i < count && result; ++i)
+        result &= (remained[i] == i);
+    test_log(result, __FUNCTION__, "capacity: %u, threads: %u, rounds: %u", (unsigned)capacity, (unsigned)threads, (unsigned)rounds);
+    return (result) ? 0 : 1;
+}
+
+template <size_t SegmentSize>
+size_t test_unbounded_fifo_order(size_t items, size_t rounds)
+{
+    lockfree::unbounded_queue<size_t, SegmentSize> q;
+    bool result = true;
+    for (size_t round = 0; round < rounds && result; ++round)
+    {
+        for (size_t i = 0; i < items; ++i)
+            result &= q.enqueue(round * items + i);
+        for (size_t i = 0; i < items; ++i)
+        {
+            size_t out = 0;
+            result &= (q.dequeue(out) && out == round * items + i);
+        }
+        size_t out = 0;
+        result &= !q.dequeue(out);
+    }
+    // Every segment of the first round is recycled by the later rounds
+    size_t expected_segments = items / SegmentSize + 3;
+    result &= (q.guess_allocated_segments() <= expected_segments);
+    test_log(result, __FUNCTION__, "segment size: %u, items: %u, rounds: %u, allocated segments: %u",
+             (unsigned)SegmentSize, (unsigned)items, (unsigned)rounds, (unsigned)q.guess_allocated_segments());
+    return (result) ? 0 : 1;
+}
+
+// The owner pops in LIFO order and a thief steals in FIFO order, across the buffer growth
+size_t test_deque_order(size_t initial_capacity, size_t items)
+{
+    lockfree::work_stealing_deque<size_t> d{ initial_capacity };
+    bool result = true;
+    for (size_t i = 0; i < items; ++i)
+        d.push(i);
+    result &= (d.guess_size() == items && d.guess_capacity() >= items);
+    for (size_t i = 0; i < items / 2; ++i)
+    {
+        size_t out = 0;
+        result &= (d.steal(out) && out == i);
+    }
+    for (size_t i = items; i > items / 2; --i)
+    {
+        size_t out = 0;
+        result &= (d.pop(out) && out == i - 1);
+    }
+    size_t out = 0;
+    result &= (!d.pop(out) && !d.steal(out));
+    test_log(result, __FUNCTION__, "initial capacity: %u, items: %u", (unsigned)initial_capacity, (unsigned)items);
+    return (result) ? 0 : 1;
+}
+
+// The owner pushes and pops while the thieves steal, every item must be taken exactly once
+template <class ReclaimerTy>
+size_t test_deque_no_loss(size_t thieves, size_t items)
+{
+    lockfree::work_stealing_deque<size_t, ReclaimerTy> d{ 2 };
+    std::unique_ptr<std::atomic<int>[]> seen{ new std::atomic<int>[items] };
+    for (size_t i = 0; i < items; ++i)
+        seen[i].store(0);
+    std::atomic<size_t> taken{ 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thieves; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            size_t out = 0;
+            while (taken.load() < items)
+            {
+                if (d.steal(out))
+                {
+                    seen[out].fetch_add(1);
+                    taken.fetch_add(1);
+                }
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+    size_t out = 0;
+    for (size_t i = 0; i < items; ++i)
+    {
+        d.push(i);
+        // Keeps the deque shallow now and then, so that the owner races for the last element
+        if ((i % 3) == 0 && d.pop(out))
+        {
+            seen[out].fetch_add(1);
+            taken.fetch_add(1);
+        }
+    }
+    while (taken.load() < items)
+    {
+        if (d.pop(out))
+        {
+            seen[out].fetch_add(1);
+            taken.fetch_add(1);
+        }
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool result = true;
+    for (size_t i = 0; i < items; ++i)
+        result &= (seen[i].load() == 1);
+    test_log(result, __FUNCTION__, "thieves: %u, items: %u", (unsigned)thieves, (unsigned)items);
+    return (result) ? 0 : 1;
+}
+
+struct test_message: lockfree::mailbox_hook
+{
+    size_t producer;
+    size_t sequence;
+};
+
+// The messages of each producer must arrive in their order, whether the consumer pops or drains
+size_t test_mailbox_order(size_t producers, size_t messages_per_producer)
+{
+    lockfree::mailbox<test_message> box;
+    std::vector<test_message> messages(producers * messages_per_producer);
+    std::vector<size_t> expected(producers, 0);
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for (size_t i = 0; i < messages_per_producer; ++i)
+            {
+                test_message& msg = messages[p * messages_per_producer + i];
+                msg.producer = p;
+                msg.sequence = i;
+                box.push(&msg);
+            }
+        });
+    }
+    bool result = true;
+    size_t received = 0;
+    auto check = [&](test_message* msg)
+    {
+        result &= (msg->sequence == expected[msg->producer]++);
+        ++received;
+    };
+    while (received < messages.size())
+    {
+        if ((received % 2) == 0)
+            box.drain(check);
+        else if (test_message* msg = box.pop())
+            check(msg);
+    }
+    for (auto& it : threads)
+        it.join();
+    result &= (box.pop() == nullptr && box.empty());
+    test_log(result, __FUNCTION__, "producers: %u, messages: %u", (unsigned)producers, (unsigned)messages.size());
+    return (result) ? 0 : 1;
+}
+
+// The producers and the consumers sleep on a tiny queue, every item must be handed over exactly once
+template <class BlockingTy>
+size_t test_blocking_handoff(size_t capacity, size_t producers, size_t consumers, size_t items_per_producer)
+{
+    BlockingTy q{ capacity };
+    const size_t total = producers * items_per_producer;
+    const size_t items_per_consumer = total / consumers;
+    std::unique_ptr<std::atomic<int>[]> seen{ new std::atomic<int>[total] };
+    for (size_t i = 0; i < total; ++i)
+        seen[i].store(0);
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for (size_t i = 0; i < items_per_producer; ++i)
+                q.enqueue_wait(p * items_per_producer + i);
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&]()
+        {
+            size_t out = 0;
+            for (size_t i = 0; i < items_per_consumer; ++i)
+            {
+                q.dequeue_wait(out);
+                seen[out].fetch_add(1);
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool result = true;
+    for (size_t i = 0; i < total; ++i)
+        result &= (seen[i].load() == 1);
+    test_log(result, __FUNCTION__, "capacity: %u, producers: %u, consumers: %u, items: %u",
+             (unsigned)capacity, (unsigned)producers, (unsigned)consumers, (unsigned)total);
+    return (result) ? 0 : 1;
+}
+
+size_t test_blocking_timeout()
+{
+    lockfree::blocking<lockfree::queue<size_t>> q{ 1 };
+    size_t out = 0;
+    auto begin = std::chrono::steady_clock::now();
+    bool result = !q.dequeue_wait(out, std::chrono::milliseconds(20));
+    result &= (std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(20));
+    result &= q.enqueue_wait(size_t{ 7 }, std::chrono::milliseconds(20));
+    result &= !q.enqueue_wait(size_t{ 8 }, std::chrono::milliseconds(20));
+    result &= (q.dequeue_wait(out, std::chrono::milliseconds(20)) && out == 7);
+    test_log(result, __FUNCTION__, "timeout: %u ms", 20u);
+    return (result) ? 0 : 1;
+}
+
+struct multicast_entry
+{
+    size_t producer;
+    size_t sequence;
+    size_t stage;
+};
+
+// Every consumer must see every entry once, and the entries of a producer in its order
+template <class RingTy>
+size_t test_multicast_fanout(size_t capacity, size_t producers, size_t consumers, size_t entries_per_producer, size_t batch)
+{
+    RingTy ring{ capacity };
+    std::vector<typename RingTy::consumer*> subscribers;
+    for (size_t c = 0; c < consumers; ++c)
+        subscribers.push_back(&ring.subscribe());
+    const size_t total = producers * entries_per_producer;
+    std::atomic<size_t> errors{ 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for (size_t i = 0; i < entries_per_producer; i += batch)
+            {
+                const size_t count = std::min(batch, entries_per_producer - i);
+                const size_t first = ring.claim(count);
+                for (size_t j = 0; j < count; ++j)
+                    ring[first + j] = multicast_entry{ p, i + j, 0 };
+                ring.publish(first, count);
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&, c]()
+        {
+            std::vector<size_t> expected(producers, 0);
+            size_t received = 0;
+            while (received < total)
+            {
+                received += subscribers[c]->consume([&](multicast_entry& entry, size_t)
+                {
+                    if (entry.sequence != expected[entry.producer]++)
+                        errors.fetch_add(1);
+                }, batch * 2);
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool result = (errors.load() == 0);
+    for (auto it : subscribers)
+        result &= (it->sequence() == total);
+    test_log(result, __FUNCTION__, "capacity: %u, producers: %u, consumers: %u, entries: %u, batch: %u",
+             (unsigned)capacity, (unsigned)producers, (unsigned)consumers, (unsigned)total, (unsigned)batch);
+    return (result) ? 0 : 1;
+}
+
+// A stage sees an entry only after the stages it depends on have finished it,
+// and the producer does not overwrite a slot which the last stage has not finished
+template <class RingTy>
+size_t test_multicast_pipeline(size_t capacity, size_t entries)
+{
+    RingTy ring{ capacity };
+    auto& first_stage = ring.subscribe();
+    auto& side_stage = ring.subscribe();
+    auto& second_stage = ring.subscribe({ &first_stage });
+    auto& last_stage = ring.subscribe({ &second_stage, &side_stage });
+    std::atomic<size_t> errors{ 0 };
+
+    auto run_stage = [&](typename RingTy::consumer& stage, size_t from, size_t to)
+    {
+        return [&, from, to]()
+        {
+            size_t received = 0;
+            while (received < entries)
+            {
+                received += stage.consume([&](multicast_entry& entry, size_t seq)
+                {
+                    if (entry.sequence != seq || entry.stage != from)
+                        errors.fetch_add(1);
+                    entry.stage = to;
+                });
+            }
+        };
+    };
+    std::vector<std::thread> threads;
+    threads.emplace_back(run_stage(first_stage, 0, 1));
+    threads.emplace_back(run_stage(second_stage, 1, 2));
+    threads.emplace_back(run_stage(last_stage, 2, 3));
+    threads.emplace_back([&]()
+    {
+        size_t received = 0;
+        while (received < entries)
+        {
+            received += side_stage.consume([&](multicast_entry& entry, size_t seq)
+            {
+                if (entry.sequence != seq)
+                    errors.fetch_add(1);
+            });
+        }
+    });
+    for (size_t i = 0; i < entries; ++i)
+        ring.push(multicast_entry{ 0, i, 0 });
+    for (auto& it : threads)
+        it.join();
+
+    size_t first = 0;
+    bool result = (errors.load() == 0 && last_stage.sequence() == entries);
+    result &= (ring.try_claim(first) && first == entries);
+    test_log(result, __FUNCTION__, "capacity: %u, entries: %u", (unsigned)capacity, (unsigned)entries);
+    return (result) ? 0 : 1;
+}
+
+// The producer must not claim a slot which a consumer has not finished
+size_t test_multicast_gating()
+{
+    lockfree::multicast_ring<size_t> ring{ 4 };
+    auto& reader = ring.subscribe();
+    size_t first = 0;
+    bool result = (ring.try_claim(first, 4) && first == 0);
+    ring.publish(first, 4);
+    result &= !ring.try_claim(first);
+    size_t taken = reader.try_consume([](size_t&, size_t) {}, 1);
+    result &= (taken == 1 && ring.try_claim(first) && first == 4);
+    result &= !ring.try_claim(first);
+    ring.publish(first);
+    taken = reader.try_consume([](size_t&, size_t) {});
+    result &= (taken == 4 && reader.try_consume([](size_t&, size_t) {}) == 0);
+    test_log(result, __FUNCTION__, "capacity: %u", (unsigned)ring.capacity);
+    return (result) ? 0 : 1;
+}
+
+// Fills the queue, fails once on each side, and reads the counters (all zero without VEE_TELEMETRY)
+template <class QueueTy>
+size_t test_queue_telemetry(size_t capacity)
+{
+    QueueTy q{ capacity };
+    bool result = true;
+    for (size_t i = 0; i < q.capacity; ++i)
+        result &= q.enqueue(i);
+    result &= (q.guess_size() == q.capacity && !q.enqueue(q.capacity));
+    telemetry::snapshot full = q.collect_telemetry();
+    size_t out = 0;
+    while (q.dequeue(out));
+    result &= (q.guess_size() == 0 && !q.dequeue(out));
+    telemetry::snapshot drained = q.collect_telemetry();
+#if VEE_TELEMETRY
+    result &= (full.full_failures == 1 && full.high_water == q.capacity && full.size == q.capacity);
+    result &= (drained.empty_failures == 2 && drained.high_water == q.capacity && drained.size == 0);
+    q.reset_telemetry();
+    result &= (q.collect_telemetry().full_failures == 0);
+#else
+    result &= (full.full_failures == 0 && full.size == q.capacity && drained.empty_failures == 0 && drained.size == 0);
+#endif
+    test_log(result, __FUNCTION__, "capacity: %u, telemetry: %u", (unsigned)q.capacity, (unsigned)VEE_TELEMETRY);
+    return (result) ? 0 : 1;
+}
+
+size_t test_stack_telemetry(size_t capacity)
+{
+    lockfree::stack<size_t> s{ capacity };
+    bool result = true;
+    for (size_t i = 0; i < capacity; ++i)
+        result &= s.push(i);
+    result &= !s.push(capacity);
+    telemetry::snapshot full = s.collect_telemetry();
+    size_t out = 0;
+    while (s.pop(out));
+    telemetry::snapshot drained = s.collect_telemetry();
+#if VEE_TELEMETRY
+    result &= (full.full_failures == 1 && full.size == capacity && full.high_water == capacity);
+    result &= (drained.empty_failures == 1 && drained.size == 0 && s.guess_size() == 0);
+#else
+    result &= (full.full_failures == 0 && drained.empty_failures == 0);
+#endif
+    test_log(result, __FUNCTION__, "capacity: %u, telemetry: %u", (unsigned)capacity, (unsigned)VEE_TELEMETRY);
+    return (result) ? 0 : 1;
+}
+
+// The threads record into their own shards, the snapshot must still add up every event
+size_t test_telemetry_shards(size_t threads, size_t rounds)
+{
+    lockfree::atqueue<size_t> q{ 4 };
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&]()
+        {
+            size_t out = 0;
+            for (size_t i = 0; i < rounds; ++i)
+                q.dequeue(out);
+        });
+    }
+    for (auto& it : pool)
+        it.join();
+    const uint64_t expected = (VEE_TELEMETRY) ? threads * rounds : 0;
+    bool result = (q.collect_telemetry().empty_failures == expected);
+    test_log(result, __FUNCTION__, "threads: %u, rounds: %u, telemetry: %u", (unsigned)threads, (unsigned)rounds, (unsigned)VEE_TELEMETRY);
+    return (result) ? 0 : 1;
+}
+
+std::atomic<size_t> reclaimed_counter{ 0 };
+
+void count_reclaimed(void* ptr)
+{
+    delete static_cast<size_t*>(ptr);
+    reclaimed_counter.fetch_add(1);
+}
+
+size_t test_ebr_grace_period(size_t objects)
+{
+    reclaimed_counter.store(0);
+    std::atomic<int> phase{ 0 };
+    // A reader pins the current epoch until the writer has retired and flushed everything
+    std::thread reader([&]()
+    {
+        lockfree::ebr::guard guard;
+        phase.store(1);
+        while (phase.load() != 2)
+            std::this_thread::yield();
+    });
+    while (phase.load() != 1)
+        std::this_thread::yield();
+    for (size_t i = 0; i < objects; ++i)
+        lockfree::ebr::retire(new size_t{ i }, &count_reclaimed);
+    lockfree::ebr::flush();
+    lockfree::ebr::flush();
+    bool result = (reclaimed_counter.load() == 0);
+    phase.store(2);
+    reader.join();
+    lockfree::ebr::synchronize();
+    result &= (reclaimed_counter.load() == objects);
+    test_log(result, __FUNCTION__, "objects: %u, reclaimed: %u", (unsigned)objects, (unsigned)reclaimed_counter.load());
+    return (result) ? 0 : 1;
+}
+
+size_t test_hazard_protection(size_t objects)
+{
+    reclaimed_counter.store(0);
+    std::atomic<size_t*> shared{ new size_t{ 0 } };
+    std::atomic<int> phase{ 0 };
+    // A reader publishes the first object, the others must be reclaimed regardless of the reader
+    std::thread reader([&]()
+    {
+        lockfree::hazard_pointer::guard guard;
+        guard.protect(shared);
+        phase.store(1);
+        while (phase.load() != 2)
+            std::this_thread::yield();
+    });
+    while (phase.load() != 1)
+        std::this_thread::yield();
+    for (size_t i = 0; i < objects; ++i)
+        lockfree::hazard_pointer::retire(shared.exchange(new size_t{ i + 1 }), &count_reclaimed);
+    lockfree::hazard_pointer::flush();
+    bool result = (reclaimed_counter.load() == objects - 1);
+    result &= (lockfree::hazard_pointer::guess_pending() <= 1);
+    phase.store(2);
+    reader.join();
+    lockfree::hazard_pointer::synchronize();
+    result &= (reclaimed_counter.load() == objects);
+    delete shared.load();
+    test_log(result, __FUNCTION__, "objects: %u, reclaimed: %u", (unsigned)objects, (unsigned)reclaimed_counter.load());
+    return (result) ? 0 : 1;
+}
+
+template <class StackTy>
+size_t test_stack_no_loss(size_t capacity, size_t pushers, size_t poppers, size_t items_per_pusher)
+{
+    StackTy s{ capacity };
+    const size_t total = pushers * items_per_pusher;
+    std::unique_ptr<std::atomic<int>[]> seen{ new std::atomic<int>[total] };
+    for (size_t i = 0; i < total; ++i)
+        seen[i].store(0);
+    std::atomic<size_t> popped{ 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < pushers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for (size_t i = 0; i < items_per_pusher; ++i)
+            {
+                while (!s.push(p * items_per_pusher + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t c = 0; c < poppers; ++c)
+    {
+        threads.emplace_back([&]()
+        {
+            size_t out = 0;
+            while (popped.load() < total)
+            {
+                if (s.pop(out))
+                {
+                    seen[out].fetch_add(1);
+                    popped.fetch_add(1);
+                }
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool result = true;
+    for (size_t i = 0; i < total; ++i)
+        result &= (seen[i].load() == 1);
+    test_log(result, __FUNCTION__, "capacity: %u, pushers: %u, poppers: %u, items: %u",
+             (unsigned)capacity, (unsigned)pushers, (unsigned)poppers, (unsigned)total);
+    return (result) ? 0 : 1;
+}
+
+template <class QueueTy>
+size_t test_no_loss(size_t capacity, size_t producers, size_t consumers, size_t items_per_producer)
+{
+    QueueTy q{ capacity };
+    const size_t total = producers * items_per_producer;
+    std::unique_ptr<std::atomic<int>[]> seen{ new std::atomic<int>[total] };
+    for (size_t i = 0; i < total; ++i)
+        seen[i].store(0);
+    std::atomic<size_t> consumed{ 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+        {
+            for (size_t i = 0; i < items_per_producer; ++i)
+            {
+                while (!q.enqueue(p * items_per_producer + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&]()
+        {
+            size_t out = 0;
+            while (consumed.load() < total)
+            {
+                if (q.dequeue(out))
+                {
+                    seen[out].fetch_add(1);
+                    consumed.fetch_add(1);
+                }
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool result = true;
+    for (size_t i = 0; i < total; ++i)
+        result &= (seen[i].load() == 1);
+    test_log(result, __FUNCTION__, "capacity: %u, producers: %u, consumers: %u, items: %u",
+             (unsigned)capacity, (unsigned)producers, (unsigned)consumers, (unsigned)total);
+    return (result) ? 0 : 1;
+}
+
+// Not default constructible, counts the living instances
+struct tracked_t
+{
+    static std::atomic<int> alive;
+    size_t value;
+    explicit tracked_t(size_t __value): value{ __value } { alive.fetch_add(1); }
+    tracked_t(tracked_t&& other) noexcept: value{ other.value } { alive.fetch_add(1); }
+    tracked_t& operator=(tracked_t&& other) noexcept { value = other.value; return *this; }
+    ~tracked_t() { alive.fetch_sub(1); }
+};
+
+std::atomic<int> tracked_t::alive{ 0 };
+
+// A container holds exactly the elements between their enqueue and dequeue, and destroys the remaining ones
+template <class QueueTy>
+size_t test_queue_lifetime(size_t capacity)
+{
+    tracked_t::alive.store(0);
+    bool result = true;
+    {
+        QueueTy q{ capacity };
+        result &= (tracked_t::alive.load() == 0);
+        for (size_t i = 0; i < capacity; ++i)
+            result &= q.emplace(i);
+        result &= (tracked_t::alive.load() == (int)capacity);
+        tracked_t out{ capacity };
+        result &= (q.dequeue(out) && out.value == 0);
+        lockfree::uninitialized<tracked_t> raw;
+        if (capacity > 1)
+        {
+            result &= (q.try_dequeue(raw) && raw->value == 1);
+            raw.destroy();
+        }
+        result &= (tracked_t::alive.load() == (int)std::max<size_t>(capacity - 1, 1));
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, alive: %d", (unsigned)capacity, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+template <class StackTy>
+size_t test_stack_lifetime(size_t capacity)
+{
+    tracked_t::alive.store(0);
+    bool result = true;
+    {
+        StackTy s{ capacity };
+        result &= (tracked_t::alive.load() == 0);
+        for (size_t i = 0; i < capacity; ++i)
+            result &= s.emplace(i);
+        result &= !s.emplace(capacity);
+        result &= (tracked_t::alive.load() == (int)capacity);
+        tracked_t out{ capacity };
+        result &= (s.pop(out) && out.value == capacity - 1);
+        lockfree::uninitialized<tracked_t> raw;
+        if (capacity > 1)
+        {
+            result &= (s.try_pop(raw) && raw->value == capacity - 2);
+            raw.destroy();
+        }
+        result &= (tracked_t::alive.load() == (int)std::max<size_t>(capacity - 1, 1));
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, alive: %d", (unsigned)capacity, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// Throws from the constructor for the poison value, the move does not throw
+struct fragile_t: tracked_t
+{
+    static const size_t poison = 13;
+    explicit fragile_t(size_t __value): tracked_t{ __value }
+    {
+        if (__value == poison)
+            throw std::runtime_error("poisoned element");
+    }
+};
+
+const size_t fragile_t::poison;
+
+// A throwing constructor must leave the container as it was: no claimed slot which is never published, no lost block
+template <class ContainerTy>
+size_t test_throwing_emplace(size_t capacity)
+{
+    using traits_t = lockfree::blocking_traits<ContainerTy>;
+    tracked_t::alive.store(0);
+    bool result = true;
+    size_t count = 0, sum = 0;
+    {
+        ContainerTy c{ capacity };
+        result &= c.emplace(1);
+        bool thrown = false;
+        try
+        {
+            c.emplace(fragile_t::poison);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        result &= thrown;
+        result &= c.emplace(2);
+        fragile_t out{ 0 };
+        while (traits_t::take(c, out))
+        {
+            sum += out.value;
+            ++count;
+        }
+        result &= (count == 2 && sum == 3);
+        for (size_t i = 0; i < capacity; ++i)
+            result &= c.emplace(i);
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, taken: %u, alive: %d", (unsigned)capacity, (unsigned)count, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// The elements before the throwing one are enqueued, the rest is not
+template <class QueueTy>
+size_t test_throwing_enqueue_bulk(size_t capacity)
+{
+    tracked_t::alive.store(0);
+    bool result = true;
+    size_t count = 0, sum = 0;
+    {
+        QueueTy q{ capacity };
+        const size_t values[] = { 1, 2, fragile_t::poison, 4 };
+        bool thrown = false;
+        try
+        {
+            q.enqueue_bulk(std::begin(values), std::end(values));
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        result &= thrown;
+        fragile_t out{ 0 };
+        while (q.dequeue(out))
+        {
+            sum += out.value;
+            ++count;
+        }
+        result &= (count == 2 && sum == 3);
+        result &= (q.enqueue_bulk(std::begin(values), std::begin(values) + 2) == 2);
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, taken: %u, alive: %d", (unsigned)capacity, (unsigned)count, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// The move assignment throws while armed, so a take fails after the element has been claimed
+struct brittle_t: tracked_t
+{
+    static bool armed;
+    explicit brittle_t(size_t __value): tracked_t{ __value } {}
+    brittle_t(brittle_t&& other) = default;
+    brittle_t& operator=(brittle_t&& other)
+    {
+        if (armed)
+            throw std::runtime_error("brittle assignment");
+        tracked_t::operator=(std::move(other));
+        return *this;
+    }
+};
+
+bool brittle_t::armed = false;
+
+// A throwing take drops the claimed element, and the container keeps all of its capacity
+template <class ContainerTy>
+size_t test_throwing_take(size_t capacity)
+{
+    using traits_t = lockfree::blocking_traits<ContainerTy>;
+    tracked_t::alive.store(0);
+    bool result = true;
+    size_t count = 0;
+    {
+        ContainerTy c{ capacity };
+        for (size_t i = 0; i < capacity; ++i)
+            result &= traits_t::put(c, brittle_t{ i });
+        brittle_t out{ 0 };
+        bool thrown = false;
+        brittle_t::armed = true;
+        try
+        {
+            traits_t::take(c, out);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        brittle_t::armed = false;
+        result &= thrown;
+        result &= (tracked_t::alive.load() == (int)capacity);
+        while (traits_t::take(c, out))
+            ++count;
+        result &= (count == capacity - 1);
+        for (size_t i = 0; i < capacity; ++i)
+            result &= traits_t::put(c, brittle_t{ i });
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, taken: %u, alive: %d", (unsigned)capacity, (unsigned)count, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// A throw in the middle of a bulk dequeue drops the claimed rest(MPMC) or leaves it in the ring(SPSC)
+template <class QueueTy>
+size_t test_throwing_dequeue_bulk()
+{
+    const size_t capacity = 4;
+    tracked_t::alive.store(0);
+    bool result = true;
+    size_t count = 0;
+    {
+        QueueTy q{ capacity };
+        for (size_t i = 0; i < capacity; ++i)
+            result &= q.enqueue(brittle_t{ i });
+        brittle_t out[capacity] = { brittle_t{ 0 }, brittle_t{ 0 }, brittle_t{ 0 }, brittle_t{ 0 } };
+        bool thrown = false;
+        brittle_t::armed = true;
+        try
+        {
+            q.dequeue_bulk(out, capacity);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        brittle_t::armed = false;
+        result &= thrown;
+        while (q.dequeue(out[0]))
+            ++count;
+        result &= (count == (QueueTy::policy_t::multi_consumer ? 0 : capacity - 1));
+        for (size_t i = 0; i < capacity; ++i)
+            result &= q.enqueue(brittle_t{ i });
+        result &= (q.dequeue_bulk(out, capacity) == capacity);
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "left: %u, alive: %d", (unsigned)count, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// Neither the conversion from a string nor the move is noexcept
+struct wrapped_t
+{
+    wrapped_t(std::string&& __text): text{ std::move(__text) } {}
+    wrapped_t(wrapped_t&& other): text{ std::move(other.text) } {}
+    wrapped_t& operator=(wrapped_t&& other) { text = std::move(other.text); return *this; }
+    std::string text;
+};
+
+// A put which fails on a full container must not move from the value, a blocking enqueue forwards it again
+template <class ContainerTy>
+size_t test_failed_put_keeps_value(size_t capacity)
+{
+    using traits_t = lockfree::blocking_traits<ContainerTy>;
+    bool result = true;
+    ContainerTy c{ capacity };
+    for (size_t i = 0; i < capacity; ++i)
+        result &= traits_t::put(c, std::string(1, static_cast<char>('a' + i % 26)));
+    std::string text{ "a string which is too long for the small buffer" };
+    result &= !traits_t::put(c, std::move(text));
+    result &= (text == "a string which is too long for the small buffer");
+    wrapped_t value{ std::string("another string which is too long for the small buffer") };
+    result &= !traits_t::put(c, std::move(value));
+    result &= (value.text == "another string which is too long for the small buffer");
+    wrapped_t out{ std::string() };
+    size_t count = 0;
+    while (traits_t::take(c, out))
+        result &= (out.text.size() == 1 && ++count <= capacity);
+    result &= (count == capacity);
+    result &= traits_t::put(c, std::move(value));
+    result &= (traits_t::take(c, out) && out.text == "another string which is too long for the small buffer");
+    test_log(result, __FUNCTION__, "capacity: %u", (unsigned)capacity);
+    return (result) ? 0 : 1;
+}
+
+// An element type from before move semantics: a user copy constructor, hence no move constructor at all
+struct legacy_t
+{
+    explicit legacy_t(size_t __value): value{ __value } {}
+    legacy_t(const legacy_t& other): value{ other.value } {}
+    legacy_t& operator=(const legacy_t& other) { value = other.value; return *this; }
+    size_t value;
+};
+
+template <class ContainerTy>
+size_t test_copy_only_element(size_t capacity)
+{
+    using traits_t = lockfree::blocking_traits<ContainerTy>;
+    bool result = true;
+    ContainerTy c{ capacity };
+    size_t sum = 0;
+    for (size_t i = 1; i <= capacity; ++i)
+    {
+        const legacy_t value{ i };
+        result &= traits_t::put(c, value);
+        sum += i;
+    }
+    legacy_t out{ 0 };
+    while (traits_t::take(c, out))
+        sum -= out.value;
+    result &= (sum == 0);
+    test_log(result, __FUNCTION__, "capacity: %u", (unsigned)capacity);
+    return (result) ? 0 : 1;
+}
+
+// Every object of the pool is constructed and destroyed in pairs, and the pool hands it out only once
+size_t test_object_pool_lifetime(size_t capacity)
+{
+    tracked_t::alive.store(0);
+    bool result = true;
+    {
+        lockfree::object_pool<tracked_t, 4> pool{ capacity };
+        result &= (tracked_t::alive.load() == 0);
+        std::vector<lockfree::object_pool<tracked_t, 4>::handle> handles;
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            handles.push_back(pool.acquire(i));
+            result &= (handles.back() && handles.back()->value == i);
+        }
+        result &= !pool.acquire(capacity);
+        result &= (tracked_t::alive.load() == (int)capacity);
+        std::vector<tracked_t*> ptrs;
+        for (auto& it : handles)
+            ptrs.push_back(it.get());
+        std::sort(ptrs.begin(), ptrs.end());
+        result &= (std::unique(ptrs.begin(), ptrs.end()) == ptrs.end());
+        lockfree::object_pool<tracked_t, 4>::handle moved = std::move(handles.front());
+        result &= (!handles.front() && moved && moved->value == 0);
+        handles.clear();
+        result &= (tracked_t::alive.load() == 1);
+        moved.reset();
+        result &= (tracked_t::alive.load() == 0);
+        // Every object is available again to the calling thread
+        for (size_t i = 0; i < capacity; ++i)
+            handles.push_back(pool.acquire(i));
+        result &= (handles.back() && !pool.acquire(capacity));
+    }
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "capacity: %u, alive: %d", (unsigned)capacity, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+// The threads acquire and release objects and mark them busy, no object may be handed out twice at once
+size_t test_object_pool_exclusive(size_t threads, size_t per_thread, size_t rounds)
+{
+    // Two full caches for every thread(and the calling one) on top of the objects in use
+    const size_t capacity = (threads + 1) * (per_thread + 16);
+    lockfree::object_pool<size_t, 8> pool{ capacity };
+    // Learns the addresses of the objects to keep the busy flags aside
+    std::vector<size_t*> addrs;
+    for (size_t i = 0; i < capacity; ++i)
+        addrs.push_back(pool.create(i));
+    for (size_t* it : addrs)
+        pool.destroy(it);
+    std::sort(addrs.begin(), addrs.end());
+    std::unique_ptr<std::atomic<int>[]> busy{ new std::atomic<int>[capacity] };
+    for (size_t i = 0; i < capacity; ++i)
+        busy[i].store(0);
+    auto busy_flag = [&](size_t* ptr) -> std::atomic<int>&
+    {
+        return busy[std::lower_bound(addrs.begin(), addrs.end(), ptr) - addrs.begin()];
+    };
+
+    std::atomic<bool> result{ true };
+    std::vector<std::thread> pool_threads;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        pool_threads.emplace_back([&, t]()
+        {
+            std::vector<size_t*> held;
+            for (size_t r = 0; r < rounds; ++r)
+            {
+                for (size_t i = 0; i < per_thread; ++i)
+                {
+                    size_t* obj = pool.create(t);
+                    if (obj == nullptr || busy_flag(obj).exchange(1) != 0)
+                    {
+                        result.store(false);
+                        return;
+                    }
+                    held.push_back(obj);
+                }
+                for (size_t* obj : held)
+                {
+                    if (*obj != t)
+                        result.store(false);
+                    busy_flag(obj).store(0);
+                    pool.destroy(obj);
+                }
+                held.clear();
+            }
+        });
+    }
+    for (auto& it : pool_threads)
+        it.join();
+    test_log(result.load(), __FUNCTION__, "threads: %u, objects: %u, rounds: %u",
+             (unsigned)threads, (unsigned)per_thread, (unsigned)rounds);
+    return (result.load()) ? 0 : 1;
+}
+
+template <class ReclaimerTy>
+size_t test_hash_map_basic(size_t keys)
+{
+    lockfree::hash_map<size_t, size_t, std::hash<size_t>, std::equal_to<size_t>, ReclaimerTy> map{ 4 };
+    bool result = (map.bucket_count() == 4);
+    for (size_t i = 0; i < keys; ++i)
+        result &= map.insert(i, i * 2);
+    result &= !map.insert(0, 1);
+    result &= (map.guess_size() == keys && map.bucket_count() * decltype(map)::max_load_factor >= keys);
+    for (size_t i = 0; i < keys; i += 2)
+        result &= map.erase(i);
+    result &= !map.erase(0) && !map.erase(keys);
+    for (size_t i = 0; i < keys; ++i)
+    {
+        size_t out = 0;
+        if (i % 2)
+            result &= (map.find(i, out) && out == i * 2);
+        else
+            result &= !map.contains(i);
+    }
+    result &= (map.guess_size() == keys / 2);
+    result &= map.insert(0, 7);
+    test_log(result, __FUNCTION__, "keys: %u, buckets: %u", (unsigned)keys, (unsigned)map.bucket_count());
+    return (result) ? 0 : 1;
+}
+
+// The writers insert their own keys and erase the even ones while the readers look up the keys of everyone
+// (keys_per_writer must be even)
+template <class ReclaimerTy>
+size_t test_hash_map_concurrent(size_t writers, size_t readers, size_t keys_per_writer)
+{
+    lockfree::hash_map<size_t, size_t, std::hash<size_t>, std::equal_to<size_t>, ReclaimerTy> map{ 1 };
+    const size_t total = writers * keys_per_writer;
+    std::atomic<size_t> done{ 0 };
+    std::atomic<bool> result{ true };
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < writers; ++w)
+    {
+        threads.emplace_back([&, w]()
+        {
+            for (size_t i = w * keys_per_writer; i < (w + 1) * keys_per_writer; ++i)
+            {
+                if (!map.insert(i, i + 1))
+                    result.store(false);
+            }
+            for (size_t i = w * keys_per_writer; i < (w + 1) * keys_per_writer; i += 2)
+            {
+                if (!map.erase(i))
+                    result.store(false);
+            }
+            done.fetch_add(1);
+        });
+    }
+    for (size_t r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&, r]()
+        {
+            size_t key = r;
+            while (done.load() < writers)
+            {
+                size_t out = 0;
+                if (map.find(key % total, out) && out != key % total + 1)
+                    result.store(false);
+                key += 7;
+            }
+        });
+    }
+    for (auto& it : threads)
+        it.join();
+
+    bool final_result = result.load() && (map.guess_size() == total / 2);
+    for (size_t i = 0; i < total; ++i)
+        final_result &= (map.contains(i) == (i % 2 == 1));
+    test_log(final_result, __FUNCTION__, "writers: %u, readers: %u, keys: %u, buckets: %u",
+             (unsigned)writers, (unsigned)readers, (unsigned)total, (unsigned)map.bucket_count());
+    return (final_result) ? 0 : 1;
+}
+
+// Erased values are destroyed once reclaimed, and the values left in the map with the map
+template <class ReclaimerTy>
+size_t test_hash_map_lifetime(size_t keys)
+{
+    tracked_t::alive.store(0);
+    bool result = true;
+    {
+        lockfree::hash_map<size_t, tracked_t, std::hash<size_t>, std::equal_to<size_t>, ReclaimerTy> map;
+        for (size_t i = 0; i < keys; ++i)
+            result &= map.emplace(i, i);
+        result &= !map.emplace(0, keys);
+        for (size_t i = 0; i < keys; i += 2)
+            result &= map.erase(i);
+        ReclaimerTy::synchronize();
+        result &= (tracked_t::alive.load() == (int)(keys / 2));
+        size_t seen = 0;
+        result &= (map.visit(1, [&seen](const tracked_t& value) { seen = value.value; }) && seen == 1);
+    }
+    ReclaimerTy::synchronize();
+    result &= (tracked_t::alive.load() == 0);
+    test_log(result, __FUNCTION__, "keys: %u, alive: %d", (unsigned)keys, tracked_t::alive.load());
+    return (result) ? 0 : 1;
+}
+
+}; // !unnamed namespace
+
+size_t test_lockfree::test_all() noexcept
+{
+    size_t error = 0;
+    error += test_fifo_order<lockfree::atqueue<size_t>>(1, 4);
+    error += test_fifo_order<lockfree::atqueue<size_t>>(7, 5);
+    error += test_fifo_order<lockfree::atqueue<size_t>>(64, 3);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::spsc>>(1, 4);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::spsc>>(7, 5);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::mpsc>>(7, 5);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::spmc>>(7, 5);
+    error += test_fifo_order<lockfree::queue<size_t>>(13, 5);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::mpmc, lockfree::property::pow2_capacity>>(1, 4);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::mpmc, lockfree::property::pow2_capacity>>(7, 5);
+    error += test_fifo_order<lockfree::atqueue<size_t, lockfree::property::spsc, lockfree::property::pow2_capacity>>(64, 3);
+    error += test_fifo_order<lockfree::queue<size_t, lockfree::property::mpsc, lockfree::property::pow2_capacity>>(13, 5);
+    error += test_bulk_fifo_order<lockfree::atqueue<size_t>>(7, 3, 1000);
+    error += test_bulk_fifo_order<lockfree::atqueue<size_t>>(7, 32, 1000);
+    error += test_bulk_fifo_order<lockfree::atqueue<size_t, lockfree::property::spsc>>(7, 3, 1000);
+    error += test_bulk_fifo_order<lockfree::atqueue<size_t, lockfree::property::spsc>>(7, 32, 1000);
+    error += test_bulk_fifo_order<lockfree::queue<size_t, lockfree::property::mpsc>>(64, 16, 1000);
+    error += test_no_loss<lockfree::atqueue<size_t>>(16, 4, 4, 20000);
+    error += test_no_loss<lockfree::atqueue<size_t, lockfree::property::spsc>>(16, 1, 1, 50000);
+    error += test_no_loss<lockfree::atqueue<size_t, lockfree::property::mpsc>>(16, 4, 1, 20000);
+    error += test_no_loss<lockfree::atqueue<size_t, lockfree::property::spmc>>(16, 1, 4, 50000);
+    error += test_no_loss<lockfree::queue<size_t>>(3, 2, 3, 20000);
+    error += test_no_loss<lockfree::queue<size_t, lockfree::property::mpsc>>(3, 3, 1, 20000);
+    error += test_no_loss<lockfree::atqueue<size_t, lockfree::property::mpmc, lockfree::property::pow2_capacity>>(16, 4, 4, 20000);
+    error += test_no_loss<lockfree::atqueue<size_t, lockfree::property::spsc, lockfree::property::pow2_capacity>>(5, 1, 1, 50000);
+    error += test_lifo_order<lockfree::stack<size_t>>(1, 4);
+    error += test_lifo_order<lockfree::stack<size_t>>(13, 5);
+    error += test_index_stack_exclusive(4, 8, 100000);
+    error += test_index_stack_chains(16, 8, 50000);
+    error += test_stack_no_loss<lockfree::stack<size_t>>(8, 4, 4, 20000);
+    error += test_stack_no_loss<lockfree::stack<size_t>>(1, 2, 2, 20000);
+    error += test_lifo_order<lockfree::stack<size_t, lockfree::property::spsc>>(1, 4);
+    error += test_lifo_order<lockfree::stack<size_t, lockfree::property::spmc>>(100, 5);
+    error += test_stack_no_loss<lockfree::stack<size_t, lockfree::property::spmc>>(8, 1, 4, 20000);
+    error += test_stack_no_loss<lockfree::stack<size_t, lockfree::property::spsc>>(200, 1, 1, 20000);
+    error += test_lifo_order<lockfree::stack<size_t, lockfree::property::mpmc, 8>>(13, 5);
+    error += test_stack_no_loss<lockfree::stack<size_t, lockfree::property::mpmc, 8>>(8, 4, 4, 20000);
+    error += test_stack_no_loss<lockfree::stack<size_t, lockfree::property::mpmc, 2>>(1, 3, 3, 20000);
+    error += test_ebr_grace_period(10);
+    error += test_ebr_grace_period(1000);
+    error += test_hazard_protection(10);
+    error += test_hazard_protection(1000);
+    error += test_unbounded_fifo_order<1>(100, 10);
+    error += test_unbounded_fifo_order<4>(1000, 10);
+    error += test_no_loss<lockfree::unbounded_queue<size_t, 4>>(1, 4, 4, 20000);
+    error += test_no_loss<lockfree::unbounded_queue<size_t>>(1, 2, 3, 50000);
+    error += test_no_loss<lockfree::unbounded_queue<size_t, 4, lockfree::hazard_pointer>>(1, 4, 4, 20000);
+    error += test_mailbox_order(1, 1000);
+    error += test_mailbox_order(4, 50000);
+    error += test_blocking_timeout();
+    error += test_blocking_handoff<lockfree::blocking<lockfree::queue<size_t>>>(2, 3, 3, 20000);
+    error += test_blocking_handoff<lockfree::blocking<lockfree::queue<size_t, lockfree::property::mpsc>>>(1, 4, 1, 20000);
+    error += test_blocking_handoff<lockfree::blocking<lockfree::stack<size_t>>>(2, 2, 2, 20000);
+    error += test_queue_telemetry<lockfree::atqueue<size_t>>(8);
+    error += test_queue_telemetry<lockfree::atqueue<size_t, lockfree::property::spsc>>(8);
+    error += test_queue_telemetry<lockfree::queue<size_t, lockfree::property::mpsc, lockfree::property::pow2_capacity>>(5);
+    error += test_queue_telemetry<vee::queue<size_t>>(8);
+    error += test_stack_telemetry(8);
+    error += test_telemetry_shards(8, 10000);
+    error += test_multicast_gating();
+    error += test_multicast_fanout<lockfree::multicast_ring<multicast_entry>>(64, 1, 3, 50000, 1);
+    error += test_multicast_fanout<lockfree::multicast_ring<multicast_entry>>(64, 1, 3, 50000, 16);
+    error += test_multicast_fanout<lockfree::multicast_ring<multicast_entry, lockfree::property::MultiCore>>(64, 3, 2, 20000, 4);
+    error += test_multicast_fanout<lockfree::multicast_ring<multicast_entry, lockfree::property::MultiCore, lockfree::wait_strategy::block>>(8, 3, 3, 20000, 2);
+    error += test_multicast_fanout<lockfree::multicast_ring<multicast_entry, lockfree::property::SingleCore, lockfree::wait_strategy::busy_spin>>(256, 1, 1, 20000, 8);
+    error += test_multicast_pipeline<lockfree::multicast_ring<multicast_entry>>(16, 50000);
+    error += test_multicast_pipeline<lockfree::multicast_ring<multicast_entry, lockfree::property::SingleCore, lockfree::wait_strategy::block>>(4, 20000);
+    error += test_multicast_pipeline<lockfree::multicast_ring<multicast_entry, lockfree::property::MultiCore, lockfree::wait_strategy::block>>(4, 20000);
+    error += test_deque_order(1, 100);
+    error += test_deque_order(64, 1000);
+    error += test_deque_no_loss<lockfree::ebr>(3, 100000);
+    error += test_deque_no_loss<lockfree::hazard_pointer>(3, 100000);
+    error += test_queue_lifetime<lockfree::atqueue<tracked_t>>(1);
+    error += test_queue_lifetime<lockfree::atqueue<tracked_t>>(8);
+    error += test_queue_lifetime<lockfree::atqueue<tracked_t, lockfree::property::spsc>>(8);
+    error += test_queue_lifetime<lockfree::queue<tracked_t, lockfree::property::mpsc>>(8);
+    error += test_queue_lifetime<lockfree::unbounded_queue<tracked_t, 4>>(10);
+    error += test_stack_lifetime<lockfree::stack<tracked_t>>(1);
+    error += test_stack_lifetime<lockfree::stack<tracked_t, lockfree::property::mpmc, 4>>(8);
+    error += test_throwing_emplace<lockfree::atqueue<fragile_t>>(4);
+    error += test_throwing_emplace<lockfree::atqueue<fragile_t, lockfree::property::spsc>>(4);
+    error += test_throwing_emplace<lockfree::queue<fragile_t, lockfree::property::mpmc, lockfree::property::pow2_capacity>>(4);
+    error += test_throwing_emplace<lockfree::unbounded_queue<fragile_t, 4>>(1);
+    error += test_throwing_emplace<lockfree::stack<fragile_t>>(2);
+    error += test_throwing_enqueue_bulk<lockfree::atqueue<fragile_t>>(8);
+    error += test_throwing_enqueue_bulk<lockfree::atqueue<fragile_t, lockfree::property::spsc>>(8);
+    error += test_throwing_take<lockfree::atqueue<brittle_t>>(4);
+    error += test_throwing_take<lockfree::atqueue<brittle_t, lockfree::property::spsc>>(4);
+    error += test_throwing_take<lockfree::unbounded_queue<brittle_t, 4>>(6);
+    error += test_throwing_take<lockfree::stack<brittle_t>>(3);
+    error += test_throwing_take<lockfree::stack<brittle_t, lockfree::property::spsc>>(3);
+    error += test_throwing_dequeue_bulk<lockfree::atqueue<brittle_t>>();
+    error += test_throwing_dequeue_bulk<lockfree::atqueue<brittle_t, lockfree::property::spsc>>();
+    error += test_failed_put_keeps_value<lockfree::atqueue<wrapped_t>>(3);
+    error += test_failed_put_keeps_value<lockfree::atqueue<wrapped_t, lockfree::property::spsc>>(3);
+    error += test_failed_put_keeps_value<lockfree::queue<wrapped_t, lockfree::property::mpsc>>(1);
+    error += test_failed_put_keeps_value<lockfree::stack<wrapped_t>>(3);
+    error += test_failed_put_keeps_value<lockfree::stack<wrapped_t, lockfree::property::spsc>>(2);
+    error += test_copy_only_element<lockfree::atqueue<legacy_t>>(8);
+    error += test_copy_only_element<lockfree::queue<legacy_t, lockfree::property::spsc>>(8);
+    error += test_copy_only_element<lockfree::unbounded_queue<legacy_t, 4>>(10);
+    error += test_copy_only_element<lockfree::stack<legacy_t, lockfree::property::mpmc, 4>>(8);
+    error += test_object_pool_lifetime(1);
+    error += test_object_pool_lifetime(50);
+    error += test_object_pool_exclusive(4, 20, 5000);
+    error += test_hash_map_basic<lockfree::ebr>(1000);
+    error += test_hash_map_basic<lockfree::hazard_pointer>(1000);
+    error += test_hash_map_concurrent<lockfree::ebr>(4, 4, 20000);
+    error += test_hash_map_concurrent<lockfree::hazard_pointer>(4, 4, 20000);
+    error += test_hash_map_lifetime<lockfree::ebr>(100);
+    error += test_hash_map_lifetime<lockfree::hazard_pointer>(100);
+
+    return error;
+}
+
+} // !namespace libtest
+
+} // !namespace vee
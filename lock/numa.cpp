@@ -0,0 +1,145 @@
+#include <vee/lock.h>
+#include <vee/platform.h>
+#include <vector>
+#include <algorithm>
+#if VEE_PLATFORM_LINUX
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+namespace vee {
+
+namespace lock {
+
+namespace numa {
+
+namespace /* unnamed */ {
+
+// The node of every CPU, the nodes are numbered from 0 without gaps even if the system skips some
+struct topology_t
+{
+    size_t nodes = 1;
+    std::vector<size_t> node_of_cpu;
+};
+
+#if VEE_PLATFORM_LINUX
+
+// Parses a cpulist such as "0-7,16-23" into the CPU numbers
+std::vector<size_t> parse_cpulist(const std::string& list)
+{
+    std::vector<size_t> cpus;
+    const char* it = list.c_str();
+    while (*it)
+    {
+        char* end = nullptr;
+        const unsigned long first = strtoul(it, &end, 10);
+        if (end == it)
+            break;
+        unsigned long last = first;
+        it = end;
+        if (*it == '-')
+        {
+            last = strtoul(++it, &end, 10);
+            if (end == it)
+                break;
+            it = end;
+        }
+        for (unsigned long cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(static_cast<size_t>(cpu));
+        if (*it == ',')
+            ++it;
+        else
+            break;
+    }
+    return cpus;
+}
+
+topology_t read_topology()
+{
+    topology_t result;
+    const std::string root = "/sys/devices/system/node/";
+    DIR* dir = opendir(root.c_str());
+    if (!dir)
+        return result;
+    std::vector<unsigned long> ids;
+    while (dirent* entry = readdir(dir))
+    {
+        const char* name = entry->d_name;
+        if (strncmp(name, "node", 4) != 0 || name[4] < '0' || name[4] > '9')
+            continue;
+        ids.push_back(strtoul(name + 4, nullptr, 10));
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::vector<size_t>> cpus_of_node;
+    for (unsigned long id : ids)
+    {
+        std::ifstream file{ root + "node" + std::to_string(id) + "/cpulist" };
+        std::string list;
+        if (!std::getline(file, list))
+            continue;
+        std::vector<size_t> cpus = parse_cpulist(list);
+        // A memory-only node has no CPUs, no thread ever runs on it
+        if (!cpus.empty())
+            cpus_of_node.push_back(std::move(cpus));
+    }
+    if (cpus_of_node.size() < 2)
+        return result;
+    result.nodes = cpus_of_node.size();
+    for (size_t node = 0; node < cpus_of_node.size(); ++node)
+    {
+        for (size_t cpu : cpus_of_node[node])
+        {
+            if (cpu >= result.node_of_cpu.size())
+                result.node_of_cpu.resize(cpu + 1, 0);
+            result.node_of_cpu[cpu] = node;
+        }
+    }
+    return result;
+}
+
+#else
+
+topology_t read_topology()
+{
+    return topology_t();
+}
+
+#endif
+
+const topology_t& topology()
+{
+    static const topology_t instance = read_topology();
+    return instance;
+}
+
+} // unnamed namespace
+
+size_t node_count()
+{
+    return topology().nodes;
+}
+
+size_t current_node()
+{
+    const topology_t& t = topology();
+    if (t.nodes == 1)
+        return 0;
+#if VEE_PLATFORM_LINUX
+    // A vDSO call, no system call
+    const int cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<size_t>(cpu) < t.node_of_cpu.size())
+        return t.node_of_cpu[cpu];
+#endif
+    return 0;
+}
+
+} // !namespace numa
+
+} // !namespace lock
+
+} // !namespace vee
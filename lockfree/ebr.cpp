@@ -0,0 +1,186 @@
+#include <vee/lockfree/ebr.h>
+#include <vee/platform.h>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace vee {
+
+namespace lockfree {
+
+namespace /* unnamed */ {
+
+struct retired_t
+{
+    void* ptr;
+    ebr::deleter_t deleter;
+    size_t epoch;
+};
+
+// One record per thread, records are recycled by later threads but never freed
+struct record_t
+{
+    // (local epoch << 1) | active
+    std::atomic<size_t> state { 0 };
+    std::atomic<bool> in_use { true };
+    record_t* next = nullptr;
+    size_t nesting = 0;
+    size_t retired_since_reclaim = 0;
+    std::vector<retired_t> limbo;
+    char _pad[VEE_CACHE_LINE_SIZE];
+};
+
+std::atomic<size_t> global_epoch { 0 };
+std::atomic<record_t*> registry { nullptr };
+std::atomic<size_t> pending { 0 };
+
+// Objects left behind by the exited threads
+std::mutex orphans_lock;
+std::vector<retired_t> orphans;
+std::atomic<bool> has_orphans { false };
+
+record_t* acquire_record()
+{
+    for (record_t* rec = registry.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        bool expected = false;
+        if (!rec->in_use.load(std::memory_order_relaxed) && rec->in_use.compare_exchange_strong(expected, true))
+            return rec;
+    }
+    record_t* rec = new record_t;
+    record_t* head = registry.load(std::memory_order_relaxed);
+    do
+    {
+        rec->next = head;
+    } while (!registry.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+    return rec;
+}
+
+// Calls the deleters of the objects which were retired at least two epochs ago, and keeps the others
+void reclaim(std::vector<retired_t>& list, size_t epoch)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        if (list[i].epoch + 2 <= epoch)
+            list[i].deleter(list[i].ptr);
+        else
+            list[kept++] = list[i];
+    }
+    pending.fetch_sub(list.size() - kept, std::memory_order_relaxed);
+    list.resize(kept);
+}
+
+// Advances the global epoch if every active thread has observed it, and returns the current epoch
+size_t try_advance()
+{
+    size_t epoch = global_epoch.load(std::memory_order_seq_cst);
+    for (record_t* rec = registry.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        size_t state = rec->state.load(std::memory_order_seq_cst);
+        if ((state & 1) && (state >> 1) != epoch)
+            return epoch;
+    }
+    global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    return global_epoch.load(std::memory_order_seq_cst);
+}
+
+void reclaim_orphans(size_t epoch)
+{
+    if (!has_orphans.load(std::memory_order_relaxed))
+        return;
+    std::unique_lock<std::mutex> locker{ orphans_lock, std::try_to_lock };
+    if (!locker.owns_lock())
+        return;
+    reclaim(orphans, epoch);
+    has_orphans.store(!orphans.empty(), std::memory_order_relaxed);
+}
+
+class record_holder
+{
+public:
+    ~record_holder()
+    {
+        if (!_rec)
+            return;
+        reclaim(_rec->limbo, try_advance());
+        if (!_rec->limbo.empty())
+        {
+            std::lock_guard<std::mutex> locker{ orphans_lock };
+            orphans.insert(orphans.end(), _rec->limbo.begin(), _rec->limbo.end());
+            has_orphans.store(true, std::memory_order_relaxed);
+            _rec->limbo.clear();
+        }
+        _rec->state.store(0, std::memory_order_release);
+        _rec->in_use.store(false, std::memory_order_release);
+    }
+    record_t& get()
+    {
+        if (!_rec)
+            _rec = acquire_record();
+        return *_rec;
+    }
+private:
+    record_t* _rec = nullptr;
+};
+
+thread_local record_holder local_record;
+
+} // unnamed namespace
+
+void ebr::_enter()
+{
+    record_t& rec = local_record.get();
+    if (rec.nesting++ == 0)
+    {
+        rec.state.store((global_epoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void ebr::_leave()
+{
+    record_t& rec = local_record.get();
+    if (--rec.nesting == 0)
+        rec.state.store(rec.state.load(std::memory_order_relaxed) & ~static_cast<size_t>(1), std::memory_order_release);
+}
+
+void ebr::retire(void* ptr, deleter_t deleter)
+{
+    record_t& rec = local_record.get();
+    rec.limbo.push_back(retired_t{ ptr, deleter, global_epoch.load(std::memory_order_seq_cst) });
+    pending.fetch_add(1, std::memory_order_relaxed);
+    if (++rec.retired_since_reclaim >= reclaim_threshold)
+    {
+        rec.retired_since_reclaim = 0;
+        flush();
+    }
+}
+
+void ebr::flush()
+{
+    record_t& rec = local_record.get();
+    size_t epoch = try_advance();
+    reclaim(rec.limbo, epoch);
+    reclaim_orphans(epoch);
+}
+
+void ebr::synchronize()
+{
+    record_t& rec = local_record.get();
+    flush();
+    while (!rec.limbo.empty())
+    {
+        std::this_thread::yield();
+        flush();
+    }
+}
+
+size_t ebr::guess_pending()
+{
+    return pending.load(std::memory_order_relaxed);
+}
+
+} // !namespace lockfree
+
+} // !namespace vee
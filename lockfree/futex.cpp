@@ -0,0 +1,119 @@
+#include <vee/lockfree/futex.h>
+#include <vee/platform.h>
+#if VEE_PLATFORM_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#include <cerrno>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace vee {
+
+namespace lockfree {
+
+namespace futex {
+
+#if VEE_PLATFORM_LINUX
+
+namespace /* unnamed */ {
+
+long sys_futex(std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, timeout, nullptr, 0);
+}
+
+} // unnamed namespace
+
+void wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+    sys_futex(word, FUTEX_WAIT_PRIVATE, expected, nullptr);
+}
+
+bool wait_until(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::steady_clock::time_point deadline)
+{
+    auto remained = deadline - std::chrono::steady_clock::now();
+    if (remained <= std::chrono::steady_clock::duration::zero())
+        return false;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remained).count();
+    timespec timeout;
+    timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+    timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+    if (sys_futex(word, FUTEX_WAIT_PRIVATE, expected, &timeout) == -1 && errno == ETIMEDOUT)
+        return false;
+    return true;
+}
+
+void wake(std::atomic<uint32_t>& word, uint32_t count)
+{
+    sys_futex(word, FUTEX_WAKE_PRIVATE, count, nullptr);
+}
+
+void wake_all(std::atomic<uint32_t>& word)
+{
+    sys_futex(word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr);
+}
+
+#else
+
+namespace /* unnamed */ {
+
+// The words which share a bucket wake each other, the waiters recheck their words
+struct bucket_t
+{
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+const size_t number_of_buckets = 64;
+bucket_t buckets[number_of_buckets];
+
+bucket_t& bucket_of(const std::atomic<uint32_t>& word)
+{
+    return buckets[(reinterpret_cast<uintptr_t>(&word) / sizeof(uint32_t)) % number_of_buckets];
+}
+
+} // unnamed namespace
+
+void wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+    bucket_t& bucket = bucket_of(word);
+    std::unique_lock<std::mutex> locker{ bucket.lock };
+    if (word.load(std::memory_order_acquire) == expected)
+        bucket.cv.wait(locker);
+}
+
+bool wait_until(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::steady_clock::time_point deadline)
+{
+    bucket_t& bucket = bucket_of(word);
+    std::unique_lock<std::mutex> locker{ bucket.lock };
+    if (word.load(std::memory_order_acquire) != expected)
+        return true;
+    return bucket.cv.wait_until(locker, deadline) == std::cv_status::no_timeout;
+}
+
+void wake(std::atomic<uint32_t>& word, uint32_t /*count*/)
+{
+    wake_all(word);
+}
+
+void wake_all(std::atomic<uint32_t>& word)
+{
+    bucket_t& bucket = bucket_of(word);
+    {
+        // Serializes with a waiter between its check of the word and its sleep
+        std::lock_guard<std::mutex> locker{ bucket.lock };
+    }
+    bucket.cv.notify_all();
+}
+
+#endif
+
+} // !namespace futex
+
+} // !namespace lockfree
+
+} // !namespace vee
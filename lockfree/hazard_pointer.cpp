@@ -0,0 +1,174 @@
+#include <vee/lockfree/hazard_pointer.h>
+#include <vee/platform.h>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace vee {
+
+namespace lockfree {
+
+namespace /* unnamed */ {
+
+struct retired_t
+{
+    void* ptr;
+    hazard_pointer::deleter_t deleter;
+};
+
+// One record per thread, records are recycled by later threads but never freed
+struct record_t
+{
+    std::atomic<void*> slots[hazard_pointer::slots_per_thread];
+    std::atomic<bool> in_use { true };
+    record_t* next = nullptr;
+    std::vector<retired_t> limbo;
+    char _pad[VEE_CACHE_LINE_SIZE];
+
+    record_t()
+    {
+        for (auto& it : slots)
+            it.store(nullptr, std::memory_order_relaxed);
+    }
+};
+
+std::atomic<record_t*> registry { nullptr };
+std::atomic<size_t> pending { 0 };
+
+// Objects left behind by the exited threads
+std::mutex orphans_lock;
+std::vector<retired_t> orphans;
+std::atomic<bool> has_orphans { false };
+
+record_t* acquire_record()
+{
+    for (record_t* rec = registry.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        bool expected = false;
+        if (!rec->in_use.load(std::memory_order_relaxed) && rec->in_use.compare_exchange_strong(expected, true))
+            return rec;
+    }
+    record_t* rec = new record_t;
+    record_t* head = registry.load(std::memory_order_relaxed);
+    do
+    {
+        rec->next = head;
+    } while (!registry.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+    return rec;
+}
+
+// Calls the deleters of the objects which are not published in any hazard slot, and keeps the others
+void scan(std::vector<retired_t>& list)
+{
+    if (list.empty())
+        return;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<void*> hazards;
+    for (record_t* rec = registry.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        for (auto& it : rec->slots)
+        {
+            // A pointer may carry the mark bit of a linked list, which does not belong to the address
+            uintptr_t ptr = reinterpret_cast<uintptr_t>(it.load(std::memory_order_acquire)) & ~static_cast<uintptr_t>(1);
+            if (ptr)
+                hazards.push_back(reinterpret_cast<void*>(ptr));
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        if (std::binary_search(hazards.begin(), hazards.end(), list[i].ptr))
+            list[kept++] = list[i];
+        else
+            list[i].deleter(list[i].ptr);
+    }
+    pending.fetch_sub(list.size() - kept, std::memory_order_relaxed);
+    list.resize(kept);
+}
+
+void scan_orphans()
+{
+    if (!has_orphans.load(std::memory_order_relaxed))
+        return;
+    std::unique_lock<std::mutex> locker{ orphans_lock, std::try_to_lock };
+    if (!locker.owns_lock())
+        return;
+    scan(orphans);
+    has_orphans.store(!orphans.empty(), std::memory_order_relaxed);
+}
+
+class record_holder
+{
+public:
+    ~record_holder()
+    {
+        if (!_rec)
+            return;
+        for (auto& it : _rec->slots)
+            it.store(nullptr, std::memory_order_relaxed);
+        scan(_rec->limbo);
+        if (!_rec->limbo.empty())
+        {
+            std::lock_guard<std::mutex> locker{ orphans_lock };
+            orphans.insert(orphans.end(), _rec->limbo.begin(), _rec->limbo.end());
+            has_orphans.store(true, std::memory_order_relaxed);
+            _rec->limbo.clear();
+        }
+        _rec->in_use.store(false, std::memory_order_release);
+    }
+    record_t& get()
+    {
+        if (!_rec)
+            _rec = acquire_record();
+        return *_rec;
+    }
+private:
+    record_t* _rec = nullptr;
+};
+
+thread_local record_holder local_record;
+
+} // unnamed namespace
+
+std::atomic<void*>* hazard_pointer::_local_slots()
+{
+    return local_record.get().slots;
+}
+
+void hazard_pointer::retire(void* ptr, deleter_t deleter)
+{
+    record_t& rec = local_record.get();
+    rec.limbo.push_back(retired_t{ ptr, deleter });
+    pending.fetch_add(1, std::memory_order_relaxed);
+    if (rec.limbo.size() >= scan_threshold)
+        flush();
+}
+
+void hazard_pointer::flush()
+{
+    scan(local_record.get().limbo);
+    scan_orphans();
+}
+
+void hazard_pointer::synchronize()
+{
+    record_t& rec = local_record.get();
+    flush();
+    while (!rec.limbo.empty())
+    {
+        std::this_thread::yield();
+        flush();
+    }
+}
+
+size_t hazard_pointer::guess_pending()
+{
+    return pending.load(std::memory_order_relaxed);
+}
+
+} // !namespace lockfree
+
+} // !namespace vee
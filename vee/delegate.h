@@ -51,14 +51,14 @@ public:
     }
     template <typename CallableObj> explicit compareable_function(CallableObj&& f):
         function_t(std::forward<CallableObj>(f)),
-        _type_holder(compare_function< std::remove_reference<CallableObj>::type, function_t >)
+        _type_holder(compare_function< typename std::remove_reference<CallableObj>::type, function_t >)
     {
         // empty
     }
     template <typename CallableObj> compareable_function& operator=(CallableObj&& f)
     {
         function_t::operator =(std::forward<CallableObj>(f));
-        _type_holder = compare_function < std::remove_reference<CallableObj>::type, function_t >;
+        _type_holder = compare_function < typename std::remove_reference<CallableObj>::type, function_t >;
         return *this;
     }
     friend bool operator==(const compareable_function& lhs, const compareable_function& rhs)
@@ -81,6 +81,8 @@ class delegate
 
 };
 
+// With a SharedLockable LockTy(lock::shared_spin_lock) the invocations take the shared lock and may run on several threads at once,
+// the registrations and the removals always take the exclusive lock
 template <class RTy, 
           class ...Args, 
           class LockTy, 
@@ -144,7 +146,7 @@ public:
     ~delegate() = default;
     explicit delegate(const ref_t other)
     {
-        std::lock_guard<lock_t> locker(other._mtx);
+        lock::shared_guard<lock_t> locker(other._mtx);
         _cont = other._cont;
         _usrcont = other._usrcont;
     }
@@ -292,7 +294,7 @@ public:
     }
     void operator()(args_tuple_t& args)
     {
-        std::lock_guard<lock_t> locker{ _mtx };
+        lock::shared_guard<lock_t> locker{ _mtx };
         for (auto& it : _cont)
         {
             tupleupk(static_cast<binder_t&>(it.second), args);
@@ -304,7 +306,7 @@ public:
     }
     void operator()(args_tuple_t&& args)
     {
-        std::lock_guard<lock_t> locker{ _mtx };
+        lock::shared_guard<lock_t> locker{ _mtx };
         for (auto& it : _cont)
         {
             tupleupk(static_cast<binder_t&>(it.second), static_cast<args_tuple_t&&>(args));
@@ -318,7 +320,7 @@ public:
     template <typename ...FwdArgs>
     void operator()(FwdArgs&& ...args)
     {
-        std::lock_guard<lock_t> locker{ _mtx };
+        lock::shared_guard<lock_t> locker{ _mtx };
         for (auto& it : _cont)
         {
             it.second.operator()(std::forward<FwdArgs>(args)...);
@@ -343,7 +345,7 @@ public:
     }
     bool empty() const
     {
-        std::lock_guard<lock_t> locker{ _mtx };
+        lock::shared_guard<lock_t> locker{ _mtx };
         if (_cont.empty() && _usrcont.empty())
             return true;
         return false;
@@ -26,6 +26,8 @@ public:\
 };
 
 DECLARE_TEST_CLASS(test_type_generic);
+DECLARE_TEST_CLASS(test_lockfree);
+DECLARE_TEST_CLASS(test_lock);
 
 #undef DECLARE_TEST_CLASS
 
@@ -1,7 +1,20 @@
 #ifndef _VEE_LOCK_H_
 #define _VEE_LOCK_H_
+#include <vee/platform.h>
+#include <vee/lockfree/futex.h>
 #include <mutex>
+#include <memory>
 #include <atomic>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#pragma warning(disable:4127)
 
 namespace vee {
 
@@ -28,6 +41,59 @@ public:
 	}
 };
 
+// Tells the core that the thread is spinning(pause on x86), so that the sibling hyper-thread gets the pipeline
+inline void cpu_relax()
+{
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// Exponential backoff of a spinning waiter: 1, 2, 4, ... max_pauses pauses per round, then yields of the core
+class backoff
+{
+public:
+	static const uint32_t max_pauses = 64;
+	backoff():
+		_pauses { 1 },
+		_rounds { 0 }
+	{
+	}
+	void pause()
+	{
+		if (_pauses <= max_pauses)
+		{
+			for (uint32_t i = 0; i < _pauses; ++i)
+				cpu_relax();
+			_pauses <<= 1;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+		++_rounds;
+	}
+	uint32_t rounds() const
+	{
+		return _rounds;
+	}
+	void reset()
+	{
+		_pauses = 1;
+		_rounds = 0;
+	}
+private:
+	uint32_t _pauses;
+	uint32_t _rounds;
+};
+
+/* Test-and-test-and-set lock which parks its waiters
+   A waiter spins on a read of the word with an exponential backoff(vee::lock::backoff) for spin_rounds rounds,
+   so the waiters do not bounce the cache line while the owner works. A waiter which is still not through
+   marks the word as contended and sleeps on it(vee/lockfree/futex.h); only the unlock of a contended word
+   makes the system call. The lock is not fair. */
 class spin_lock
 {
 	spin_lock(const spin_lock&) = delete; 
@@ -35,28 +101,704 @@ class spin_lock
 	spin_lock(const spin_lock&&) = delete; 
 	void operator=(const spin_lock&&) = delete;
 public:
-	spin_lock()
+	// The rounds of the backoff before a waiter parks: the pauses double up to 64, then three yields
+	static const uint32_t spin_rounds = 10;
+	spin_lock():
+		_state { state_unlocked }
 	{
-		_lock.clear();
 	}
 	inline void lock(std::memory_order order = std::memory_order_acquire)
 	{
-		while (_lock.test_and_set(order));
+		uint32_t state = state_unlocked;
+		if (_state.compare_exchange_strong(state, state_locked, order, std::memory_order_relaxed))
+			return;
+		_lock_slow(order);
 	}
+	// Returns true if the lock has been acquired
 	inline bool try_lock(std::memory_order order = std::memory_order_acquire)
 	{
-		return _lock.test_and_set(order);
+		uint32_t state = state_unlocked;
+		return _state.compare_exchange_strong(state, state_locked, order, std::memory_order_relaxed);
 	}
 	inline void unlock(std::memory_order order = std::memory_order_release)
 	{
-		_lock.clear(order);
+		if (_state.exchange(state_unlocked, order) == state_contended)
+			lockfree::futex::wake(_state, 1);
 	}
 protected:
-	std::atomic_flag _lock;
+	enum : uint32_t
+	{
+		state_unlocked = 0,
+		state_locked,
+		state_contended // locked, and a waiter may be parked
+	};
+
+	void _lock_slow(std::memory_order order)
+	{
+		for (backoff waiter; waiter.rounds() < spin_rounds; waiter.pause())
+		{
+			uint32_t state = _state.load(std::memory_order_relaxed);
+			if (state == state_unlocked && _state.compare_exchange_weak(state, state_locked, order, std::memory_order_relaxed))
+				return;
+		}
+		// A thread which got through the parking keeps the word contended, because others may still sleep on it
+		while (_state.exchange(state_contended, order) != state_unlocked)
+			lockfree::futex::wait(_state, state_contended);
+	}
+
+	std::atomic<uint32_t> _state;
 };
 
+/* Ticket lock, the waiters get the lock in the order of their arrival
+   A waiter takes the next ticket and pauses in proportion to its distance from the ticket being served,
+   on top of the rounds of vee::lock::backoff.
+   All the waiters still read the one word which the owner advances, so every handoff invalidates it in
+   each of their caches; mcs_lock avoids that. A waiter which is not served within spin_rounds rounds sleeps
+   on the word(vee/lockfree/futex.h), so that a preempted waiter does not keep the rest of the line spinning,
+   and the unlock wakes all the sleepers to let the next ticket through. */
+class ticket_lock
+{
+	ticket_lock(const ticket_lock&) = delete;
+	void operator=(const ticket_lock&) = delete;
+	ticket_lock(const ticket_lock&&) = delete;
+	void operator=(const ticket_lock&&) = delete;
+public:
+	static const uint32_t spin_rounds = 10;
+	// Pauses per round for every ticket ahead of the waiter
+	static const uint32_t pauses_per_ticket = 16;
+	ticket_lock():
+		_next { 0 },
+		_serving { 0 },
+		_parked { 0 }
+	{
+	}
+	inline void lock()
+	{
+		const uint32_t ticket = _next.fetch_add(1, std::memory_order_relaxed);
+		const uint32_t serving = _serving.load(std::memory_order_acquire);
+		if (serving != ticket)
+			_lock_slow(ticket, serving);
+	}
+	// Succeeds only if nobody holds or waits for the lock
+	inline bool try_lock()
+	{
+		uint32_t ticket = _serving.load(std::memory_order_acquire);
+		return _next.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+	inline void unlock()
+	{
+		// Only the owner advances the word, the store and the load of the sleepers pair with _lock_slow
+		_serving.store(_serving.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		if (_parked.load(std::memory_order_seq_cst) != 0)
+			lockfree::futex::wake_all(_serving);
+	}
+protected:
+	void _lock_slow(uint32_t ticket, uint32_t serving)
+	{
+		for (backoff waiter; waiter.rounds() < spin_rounds; waiter.pause())
+		{
+			const uint32_t pauses = (ticket - serving) * pauses_per_ticket;
+			for (uint32_t i = 0; i < pauses; ++i)
+				cpu_relax();
+			serving = _serving.load(std::memory_order_acquire);
+			if (serving == ticket)
+				return;
+		}
+		_parked.fetch_add(1, std::memory_order_seq_cst);
+		while ((serving = _serving.load(std::memory_order_seq_cst)) != ticket)
+			lockfree::futex::wait(_serving, serving);
+		_parked.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	std::atomic<uint32_t> _next;
+	char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+	std::atomic<uint32_t> _serving;
+	std::atomic<uint32_t> _parked;
+};
+
+/* MCS queue lock, fair like ticket_lock, but every waiter spins on the flag of its own node
+   A waiter appends its node to the tail and waits until its predecessor hands the lock over through the node,
+   so a handoff touches only the cache lines of the owner and of its successor. The Lockable interface has
+   no room for a node, so every thread keeps a free list of nodes and the lock remembers the node of its owner;
+   a thread may hold any number of mcs_locks and unlock them in any order. A waiter which is not served within
+   spin_rounds rounds of the backoff sleeps on its flag. */
+class mcs_lock
+{
+	mcs_lock(const mcs_lock&) = delete;
+	void operator=(const mcs_lock&) = delete;
+	mcs_lock(const mcs_lock&&) = delete;
+	void operator=(const mcs_lock&&) = delete;
+public:
+	static const uint32_t spin_rounds = 10;
+	mcs_lock():
+		_tail { nullptr },
+		_owner { nullptr }
+	{
+	}
+	inline void lock()
+	{
+		node_t* node = _acquire_node();
+		node_t* prev = _tail.exchange(node, std::memory_order_acq_rel);
+		if (prev)
+		{
+			prev->next.store(node, std::memory_order_release);
+			_wait(*node);
+		}
+		_owner = node;
+	}
+	inline bool try_lock()
+	{
+		node_t* node = _acquire_node();
+		node_t* expected = nullptr;
+		if (!_tail.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			_release_node(node);
+			return false;
+		}
+		_owner = node;
+		return true;
+	}
+	inline void unlock()
+	{
+		node_t* node = _owner;
+		node_t* next = node->next.load(std::memory_order_acquire);
+		if (!next)
+		{
+			node_t* expected = node;
+			if (_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed))
+			{
+				_release_node(node);
+				return;
+			}
+			// A successor has already swapped the tail but has not linked itself yet
+			for (backoff waiter; (next = node->next.load(std::memory_order_acquire)) == nullptr; waiter.pause());
+		}
+		// The successor may run off with the lock as soon as it sees the flag, the wake only needs the address
+		if (next->state.exchange(node_granted, std::memory_order_release) == node_parked)
+			lockfree::futex::wake(next->state, 1);
+		_release_node(node);
+	}
+protected:
+	enum : uint32_t
+	{
+		node_granted = 0,
+		node_waiting,
+		node_parked
+	};
+
+	struct node_t
+	{
+		std::atomic<node_t*> next;
+		std::atomic<uint32_t> state;
+		node_t* free_next;
+		char _pad[VEE_CACHE_LINE_SIZE - sizeof(void*) * 3];
+	};
+
+	// The nodes of a thread, deleted when the thread exits
+	struct node_cache
+	{
+		node_t* head = nullptr;
+		~node_cache()
+		{
+			while (head)
+			{
+				node_t* next = head->free_next;
+				delete head;
+				head = next;
+			}
+		}
+	};
+
+	static node_cache& _cache()
+	{
+		static thread_local node_cache cache;
+		return cache;
+	}
+
+	static node_t* _acquire_node()
+	{
+		node_cache& cache = _cache();
+		node_t* node = cache.head;
+		if (node)
+			cache.head = node->free_next;
+		else
+			node = new node_t;
+		node->next.store(nullptr, std::memory_order_relaxed);
+		node->state.store(node_waiting, std::memory_order_relaxed);
+		return node;
+	}
+
+	static void _release_node(node_t* node)
+	{
+		node_cache& cache = _cache();
+		node->free_next = cache.head;
+		cache.head = node;
+	}
+
+	static void _wait(node_t& node)
+	{
+		for (backoff waiter; waiter.rounds() < spin_rounds; waiter.pause())
+		{
+			if (node.state.load(std::memory_order_acquire) == node_granted)
+				return;
+		}
+		uint32_t state = node_waiting;
+		if (!node.state.compare_exchange_strong(state, node_parked, std::memory_order_acquire, std::memory_order_acquire))
+			return; // granted meanwhile
+		while (node.state.load(std::memory_order_acquire) != node_granted)
+			lockfree::futex::wait(node.state, node_parked);
+	}
+
+	std::atomic<node_t*> _tail;
+	char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<node_t*>)];
+	node_t* _owner; // written and read by the owner only
+};
+
+/* NUMA topology of the machine, read once on the first call(lock/numa.cpp)
+   Linux reads the CPUs of every node from /sys/devices/system/node; other platforms, and a machine whose
+   topology can not be read, count as a single node. */
+namespace numa {
+
+// At least 1
+size_t node_count();
+// The node(0 ~ node_count() - 1) of the CPU which runs the calling thread, the thread may move on at any time
+size_t current_node();
+
+// The TopologyTy of basic_cohort_lock
+struct system_topology
+{
+	static size_t node_count()
+	{
+		return numa::node_count();
+	}
+	static size_t current_node()
+	{
+		return numa::current_node();
+	}
+};
+
+} // !namespace numa
+
+/* NUMA-aware cohort lock, a global ticket_lock plus a ticket_lock per node
+   A thread takes the lock of its node first, and the first thread of a cohort takes the global lock as well.
+   On unlock, the owner passes the lock to a waiter of its own node and keeps the global lock for the cohort,
+   up to max_handoffs times in a row, so the lock and the data which it guards stay in the caches of one socket;
+   then the global lock goes to the next node in the order of arrival. The global lock is released by whichever
+   thread of the cohort ends the batch, which ticket_lock allows(a std::mutex would not).
+   The owner remembers its node, so a thread which migrates while holding the lock still unlocks the right one.
+   TopologyTy provides the static node_count() and current_node(). */
+template <class TopologyTy>
+class basic_cohort_lock
+{
+	basic_cohort_lock(const basic_cohort_lock&) = delete;
+	void operator=(const basic_cohort_lock&) = delete;
+	basic_cohort_lock(const basic_cohort_lock&&) = delete;
+	void operator=(const basic_cohort_lock&&) = delete;
+public:
+	// The acquisitions within a node before the global lock is released to the other nodes
+	static const uint32_t max_handoffs = 64;
+	basic_cohort_lock():
+		_node_count { TopologyTy::node_count() },
+		_cohorts { new cohort_t[TopologyTy::node_count()] },
+		_owner { nullptr }
+	{
+	}
+	inline void lock()
+	{
+		cohort_t& cohort = _cohort();
+		cohort.waiters.fetch_add(1, std::memory_order_relaxed);
+		cohort.lock.lock();
+		cohort.waiters.fetch_sub(1, std::memory_order_relaxed);
+		if (!cohort.global_owned)
+		{
+			_global.lock();
+			cohort.global_owned = true;
+			cohort.handoffs = 0;
+		}
+		_owner = &cohort;
+	}
+	inline bool try_lock()
+	{
+		cohort_t& cohort = _cohort();
+		if (!cohort.lock.try_lock())
+			return false;
+		if (!cohort.global_owned)
+		{
+			if (!_global.try_lock())
+			{
+				cohort.lock.unlock();
+				return false;
+			}
+			cohort.global_owned = true;
+			cohort.handoffs = 0;
+		}
+		_owner = &cohort;
+		return true;
+	}
+	inline void unlock()
+	{
+		cohort_t& cohort = *_owner;
+		// A counted waiter is bound to take the local lock, so the cohort will not sit on the global lock
+		if (cohort.waiters.load(std::memory_order_relaxed) != 0 && ++cohort.handoffs < max_handoffs)
+		{
+			cohort.lock.unlock();
+			return;
+		}
+		cohort.global_owned = false;
+		_global.unlock();
+		cohort.lock.unlock();
+	}
+protected:
+	struct cohort_t
+	{
+		cohort_t():
+			waiters { 0 },
+			global_owned { false },
+			handoffs { 0 }
+		{
+		}
+		ticket_lock lock;
+		std::atomic<uint32_t> waiters; // the threads of the node in lock(), a hint for the unlock
+		bool global_owned;             // guarded by the local lock
+		uint32_t handoffs;             // guarded by the local lock
+		char _pad[VEE_CACHE_LINE_SIZE - (sizeof(ticket_lock) + sizeof(std::atomic<uint32_t>) + sizeof(bool) + sizeof(uint32_t)) % VEE_CACHE_LINE_SIZE];
+	};
+
+	cohort_t& _cohort()
+	{
+		return _cohorts[TopologyTy::current_node() % _node_count];
+	}
+
+	ticket_lock _global;
+	const size_t _node_count;
+	std::unique_ptr<cohort_t[]> _cohorts;
+	cohort_t* _owner; // written and read by the owner only
+};
+
+using cohort_lock = basic_cohort_lock<numa::system_topology>;
+
+/* Reader-writer spin lock with writer preference, SharedLockable besides Lockable
+   A reader increments the counter of its own shard(one cache line out of shard_count, chosen per thread),
+   so the readers of an uncontended lock do not write a shared cache line. A writer first takes the writer word,
+   which turns the new readers away, then waits until every shard has drained; a writer therefore is not
+   starved by a stream of readers. The readers and the writers which wait for the writer word park on it
+   after the backoff like spin_lock. A thread must not take the shared lock again while holding it,
+   a waiting writer would block the second acquisition. */
+class shared_spin_lock
+{
+	shared_spin_lock(const shared_spin_lock&) = delete;
+	void operator=(const shared_spin_lock&) = delete;
+	shared_spin_lock(const shared_spin_lock&&) = delete;
+	void operator=(const shared_spin_lock&&) = delete;
+public:
+	static const size_t shard_count = 16;
+	static const uint32_t spin_rounds = 10;
+	shared_spin_lock():
+		_writer { writer_none }
+	{
+		for (auto& it : _shards)
+			it.readers.store(0, std::memory_order_relaxed);
+	}
+	inline void lock()
+	{
+		uint32_t state = writer_none;
+		if (!_writer.compare_exchange_strong(state, writer_locked, std::memory_order_seq_cst, std::memory_order_relaxed))
+			_lock_writer_slow();
+		// The writer word is visible to the readers before the shards are read
+		for (backoff waiter; !_drained(); waiter.pause());
+	}
+	inline bool try_lock()
+	{
+		uint32_t state = writer_none;
+		if (!_writer.compare_exchange_strong(state, writer_locked, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+		if (_drained())
+			return true;
+		_release_writer();
+		return false;
+	}
+	inline void unlock()
+	{
+		_release_writer();
+	}
+	inline void lock_shared()
+	{
+		for (;;)
+		{
+			if (try_lock_shared())
+				return;
+			_wait_writer();
+		}
+	}
+	inline bool try_lock_shared()
+	{
+		if (_writer.load(std::memory_order_relaxed) != writer_none)
+			return false;
+		std::atomic<uint32_t>& readers = _shard().readers;
+		readers.fetch_add(1, std::memory_order_seq_cst);
+		if (_writer.load(std::memory_order_seq_cst) == writer_none)
+			return true;
+		readers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+	inline void unlock_shared()
+	{
+		_shard().readers.fetch_sub(1, std::memory_order_release);
+	}
+protected:
+	enum : uint32_t
+	{
+		writer_none = 0,
+		writer_locked,
+		writer_contended // locked, and a reader or a writer may be parked
+	};
+
+	struct shard_t
+	{
+		std::atomic<uint32_t> readers;
+		char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+	};
+
+	// A thread keeps the shard which it was given on its first shared lock, for every shared_spin_lock
+	shard_t& _shard()
+	{
+		static std::atomic<size_t> next { 0 };
+		static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+		return _shards[index];
+	}
+
+	bool _drained() const
+	{
+		for (auto& it : _shards)
+		{
+			if (it.readers.load(std::memory_order_seq_cst) != 0)
+				return false;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	void _lock_writer_slow()
+	{
+		for (backoff waiter; waiter.rounds() < spin_rounds; waiter.pause())
+		{
+			uint32_t state = _writer.load(std::memory_order_relaxed);
+			if (state == writer_none && _writer.compare_exchange_weak(state, writer_locked, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return;
+		}
+		while (_writer.exchange(writer_contended, std::memory_order_seq_cst) != writer_none)
+			lockfree::futex::wait(_writer, writer_contended);
+	}
+
+	// Returns when the writer word has been released at least once, the caller tries again
+	void _wait_writer()
+	{
+		for (backoff waiter; waiter.rounds() < spin_rounds; waiter.pause())
+		{
+			if (_writer.load(std::memory_order_relaxed) == writer_none)
+				return;
+		}
+		uint32_t state = _writer.load(std::memory_order_relaxed);
+		while (state != writer_none)
+		{
+			if (state == writer_contended || _writer.compare_exchange_weak(state, writer_contended, std::memory_order_relaxed))
+				lockfree::futex::wait(_writer, writer_contended);
+			state = _writer.load(std::memory_order_relaxed);
+		}
+	}
+
+	void _release_writer()
+	{
+		if (_writer.exchange(writer_none, std::memory_order_release) == writer_contended)
+			lockfree::futex::wake_all(_writer);
+	}
+
+	std::atomic<uint32_t> _writer;
+	char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+	shard_t _shards[shard_count];
+};
+
+// True if LockTy offers lock_shared and unlock_shared besides the exclusive lock
+template <class LockTy, class = void>
+struct is_shared_lockable: std::false_type
+{
+};
+
+template <class LockTy>
+struct is_shared_lockable<LockTy, decltype(std::declval<LockTy&>().lock_shared(), std::declval<LockTy&>().unlock_shared(), void())>: std::true_type
+{
+};
+
+// Holds a shared lock on a SharedLockable, and an exclusive lock on any other Lockable
+template <class LockTy, bool Shared = is_shared_lockable<LockTy>::value>
+class shared_guard
+{
+public:
+	explicit shared_guard(LockTy& lock):
+		_lock(lock)
+	{
+		_lock.lock_shared();
+	}
+	~shared_guard()
+	{
+		_lock.unlock_shared();
+	}
+private:
+	LockTy& _lock;
+
+	shared_guard(const shared_guard&) = delete;
+	void operator=(const shared_guard&) = delete;
+};
+
+template <class LockTy>
+class shared_guard<LockTy, false>
+{
+public:
+	explicit shared_guard(LockTy& lock):
+		_lock(lock)
+	{
+		_lock.lock();
+	}
+	~shared_guard()
+	{
+		_lock.unlock();
+	}
+private:
+	LockTy& _lock;
+
+	shared_guard(const shared_guard&) = delete;
+	void operator=(const shared_guard&) = delete;
+};
+
+/* Sequence lock for the read-mostly shared state
+   A writer makes the sequence odd, updates the data and makes the sequence even again.
+   A reader copies the data between two loads of the sequence and retries if the sequence has changed,
+   so the readers never write a shared cache line and never delay a writer.
+   The data must be trivially copyable, because a reader may copy it while a writer is updating it.
+   The writers must be serialized by the caller unless MultiWriter is set,
+   in which case a writer acquires the odd sequence with a CAS. */
+template <typename DataTy, bool MultiWriter = false>
+class seqlock
+{
+public:
+	using this_t = seqlock<DataTy, MultiWriter>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	static_assert(std::is_trivially_copyable<DataTy>::value, "seqlock requires a trivially copyable data type");
+
+	seqlock():
+		_seq { 0 },
+		_data {}
+	{
+	}
+	explicit seqlock(const data_t& init):
+		_seq { 0 },
+		_data(init)
+	{
+	}
+	// Returns a consistent copy of the data, retries while a writer is active
+	data_t load() const
+	{
+		data_t out;
+		for (size_t spins = 0; !try_load(out); ++spins)
+			_relax(spins);
+		return out;
+	}
+	// A single attempt, returns false if a writer was active during the copy
+	bool try_load(data_t& out) const
+	{
+		const size_t before = _seq.load(std::memory_order_acquire);
+		if (before & 1)
+			return false;
+		memcpy(&out, &_data, sizeof(data_t));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return _seq.load(std::memory_order_relaxed) == before;
+	}
+	void store(const data_t& value)
+	{
+		write([&value](data_t& data) { data = value; });
+	}
+	// Calls fn(data_t&) to update the data in place
+	template <class Fn>
+	void write(Fn&& fn)
+	{
+		write_scope scope{ *this };
+		fn(_data);
+	}
+	// Even while no writer is active, increases by two for every write
+	size_t sequence() const
+	{
+		return _seq.load(std::memory_order_acquire);
+	}
+
+private:
+	// Keeps the sequence odd while alive, so that a throwing update still ends the write
+	class write_scope
+	{
+	public:
+		explicit write_scope(ref_t lock):
+			_lock { lock },
+			_begin { lock._begin_write() }
+		{
+		}
+		~write_scope()
+		{
+			_lock._seq.store(_begin + 2, std::memory_order_release);
+		}
+	private:
+		ref_t _lock;
+		const size_t _begin;
+
+		write_scope(const write_scope&) = delete;
+		void operator=(const write_scope&) = delete;
+	};
+
+	size_t _begin_write()
+	{
+		size_t seq = _seq.load(std::memory_order_relaxed);
+		if (MultiWriter)
+		{
+			for (size_t spins = 0; ; ++spins)
+			{
+				if ((seq & 1) == 0 && _seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed))
+					break;
+				_relax(spins);
+				seq = _seq.load(std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			_seq.store(seq + 1, std::memory_order_relaxed);
+		}
+		// The odd sequence becomes visible before any store to the data
+		std::atomic_thread_fence(std::memory_order_release);
+		return seq;
+	}
+
+	// Gives the core away if a writer seems to be preempted in the middle of an update
+	static void _relax(size_t spins)
+	{
+		if (spins >= 64)
+			std::this_thread::yield();
+	}
+
+	std::atomic<size_t> _seq;
+	data_t _data;
+
+	seqlock(const ref_t) = delete;
+	seqlock(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+template <typename DataTy>
+using multi_writer_seqlock = seqlock<DataTy, true>;
+
 } // !namespace lock	
 
 } // !namespace vee
 
-#endif // !_VEE_LOCK_H_
\ No newline at end of file
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCK_H_
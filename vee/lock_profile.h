@@ -0,0 +1,383 @@
+#ifndef _VEE_LOCK_PROFILE_H_
+#define _VEE_LOCK_PROFILE_H_
+
+#include <vee/lock.h>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <utility>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lock {
+
+/* Contention profile of the locks
+   lock::profiled<LockTy> wraps any Lockable and counts its acquisitions, the acquisitions which had to wait,
+   the time spent waiting and the time the lock was held. The counters are updated while the lock is held,
+   so they add two clock reads to an acquisition but no contention of their own.
+   Every profiled lock registers its profile under a name in profile_registry; the locks which share a name
+   are summed up, and a destroyed lock leaves its counts behind, so e.g. all the delegates of one kind can be
+   profiled under one name:
+       delegate<void(), lock::profiled<lock::spin_lock>> on_packet;
+       ...
+       lock::profile_registry::instance().dump(); */
+
+// Log2 buckets of durations in nanoseconds, the bucket i counts the durations in [2^(i-1), 2^i)
+class histogram
+{
+public:
+	static const size_t bucket_count = 48;
+	using counts_t = std::array<uint64_t, bucket_count>;
+
+	histogram()
+	{
+		reset();
+	}
+	void record(uint64_t ns)
+	{
+		_buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+	}
+	// Adds the counts to out
+	void collect(counts_t& out) const
+	{
+		for (size_t i = 0; i < bucket_count; ++i)
+			out[i] += _buckets[i].load(std::memory_order_relaxed);
+	}
+	void reset()
+	{
+		for (auto& it : _buckets)
+			it.store(0, std::memory_order_relaxed);
+	}
+	static size_t bucket_of(uint64_t ns)
+	{
+		size_t bucket = 0;
+		for (; ns != 0 && bucket < bucket_count - 1; ns >>= 1)
+			++bucket;
+		return bucket;
+	}
+	// The upper bound(ns) of the bucket which reaches the given fraction of the samples, 0 without samples
+	static uint64_t percentile(const counts_t& counts, double ratio)
+	{
+		uint64_t total = 0;
+		for (auto it : counts)
+			total += it;
+		if (total == 0)
+			return 0;
+		const uint64_t rank = static_cast<uint64_t>(ratio * (total - 1)) + 1;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < bucket_count; ++i)
+		{
+			seen += counts[i];
+			if (seen >= rank)
+				return (i == 0) ? 0 : ((static_cast<uint64_t>(1) << i) - 1);
+		}
+		return (static_cast<uint64_t>(1) << (bucket_count - 1)) - 1;
+	}
+private:
+	std::atomic<uint64_t> _buckets[bucket_count];
+
+	histogram(const histogram&) = delete;
+	void operator=(const histogram&) = delete;
+};
+
+// The counts of the locks which share a name
+struct profile_snapshot
+{
+	std::string name;
+	size_t locks;          // the live and the destroyed locks under the name
+	uint64_t acquisitions;
+	uint64_t contended;    // the acquisitions which had to wait
+	uint64_t wait_ns;      // the total time spent waiting
+	uint64_t hold_ns;      // the total time of the exclusive ownership
+	histogram::counts_t wait;
+	histogram::counts_t hold;
+};
+
+class lock_profile;
+
+class profile_registry
+{
+public:
+	static profile_registry& instance()
+	{
+		static profile_registry registry;
+		return registry;
+	}
+	// Sorted by the total wait, the hottest lock first
+	std::vector<profile_snapshot> collect() const;
+	void dump(FILE* out = stdout, size_t top = 10) const;
+	// Forgets the destroyed locks and clears the counts of the live ones
+	void reset();
+
+private:
+	friend class lock_profile;
+
+	profile_registry() = default;
+	void _add(lock_profile* profile);
+	void _remove(lock_profile* profile);
+	void _rename(lock_profile* profile, const char* name);
+	static profile_snapshot& _entry(std::map<std::string, profile_snapshot>& entries, const std::string& name)
+	{
+		auto it = entries.find(name);
+		if (it == entries.end())
+		{
+			profile_snapshot blank{};
+			blank.name = name;
+			it = entries.insert(std::make_pair(name, blank)).first;
+		}
+		return it->second;
+	}
+
+	mutable std::mutex _lock;
+	std::vector<lock_profile*> _live;
+	std::map<std::string, profile_snapshot> _retired;
+
+	profile_registry(const profile_registry&) = delete;
+	void operator=(const profile_registry&) = delete;
+};
+
+// The counters of one lock, registered for its lifetime
+class lock_profile
+{
+public:
+	explicit lock_profile(const char* name):
+		_name { name },
+		_acquisitions { 0 },
+		_contended { 0 },
+		_wait_ns { 0 },
+		_hold_ns { 0 }
+	{
+		profile_registry::instance()._add(this);
+	}
+	~lock_profile()
+	{
+		profile_registry::instance()._remove(this);
+	}
+	void rename(const char* name)
+	{
+		profile_registry::instance()._rename(this, name);
+	}
+	void record_acquire(bool contended, uint64_t wait_ns)
+	{
+		_acquisitions.fetch_add(1, std::memory_order_relaxed);
+		if (!contended)
+			return;
+		_contended.fetch_add(1, std::memory_order_relaxed);
+		_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+		_wait.record(wait_ns);
+	}
+	void record_hold(uint64_t hold_ns)
+	{
+		_hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+		_hold.record(hold_ns);
+	}
+	// Adds the counts to out
+	void collect(profile_snapshot& out) const
+	{
+		out.locks += 1;
+		out.acquisitions += _acquisitions.load(std::memory_order_relaxed);
+		out.contended += _contended.load(std::memory_order_relaxed);
+		out.wait_ns += _wait_ns.load(std::memory_order_relaxed);
+		out.hold_ns += _hold_ns.load(std::memory_order_relaxed);
+		_wait.collect(out.wait);
+		_hold.collect(out.hold);
+	}
+	void reset()
+	{
+		_acquisitions.store(0, std::memory_order_relaxed);
+		_contended.store(0, std::memory_order_relaxed);
+		_wait_ns.store(0, std::memory_order_relaxed);
+		_hold_ns.store(0, std::memory_order_relaxed);
+		_wait.reset();
+		_hold.reset();
+	}
+private:
+	friend class profile_registry;
+
+	std::string _name; // guarded by the registry
+	std::atomic<uint64_t> _acquisitions;
+	std::atomic<uint64_t> _contended;
+	std::atomic<uint64_t> _wait_ns;
+	std::atomic<uint64_t> _hold_ns;
+	histogram _wait;
+	histogram _hold;
+
+	lock_profile(const lock_profile&) = delete;
+	void operator=(const lock_profile&) = delete;
+};
+
+inline std::vector<profile_snapshot> profile_registry::collect() const
+{
+	std::map<std::string, profile_snapshot> entries;
+	{
+		std::lock_guard<std::mutex> locker{ _lock };
+		entries = _retired;
+		for (const lock_profile* it : _live)
+			it->collect(_entry(entries, it->_name));
+	}
+	std::vector<profile_snapshot> result;
+	for (auto& it : entries)
+		result.push_back(std::move(it.second));
+	std::stable_sort(result.begin(), result.end(), [](const profile_snapshot& lhs, const profile_snapshot& rhs)
+	{
+		return lhs.wait_ns > rhs.wait_ns;
+	});
+	return result;
+}
+
+inline void profile_registry::dump(FILE* out, size_t top) const
+{
+	const std::vector<profile_snapshot> entries = collect();
+	fprintf(out, "%-32s %5s %12s %12s %12s %10s %10s %10s %10s\n",
+			"lock", "locks", "acquisitions", "contended", "wait(us)", "wait p99", "wait max", "hold p50", "hold p99");
+	for (size_t i = 0; i < entries.size() && i < top; ++i)
+	{
+		const profile_snapshot& it = entries[i];
+		fprintf(out, "%-32s %5u %12llu %12llu %12.1f %10llu %10llu %10llu %10llu\n",
+				it.name.c_str(), static_cast<unsigned>(it.locks),
+				static_cast<unsigned long long>(it.acquisitions), static_cast<unsigned long long>(it.contended), it.wait_ns / 1e3,
+				static_cast<unsigned long long>(histogram::percentile(it.wait, 0.99)),
+				static_cast<unsigned long long>(histogram::percentile(it.wait, 1.0)),
+				static_cast<unsigned long long>(histogram::percentile(it.hold, 0.5)),
+				static_cast<unsigned long long>(histogram::percentile(it.hold, 0.99)));
+	}
+}
+
+inline void profile_registry::reset()
+{
+	std::lock_guard<std::mutex> locker{ _lock };
+	_retired.clear();
+	for (lock_profile* it : _live)
+		it->reset();
+}
+
+inline void profile_registry::_add(lock_profile* profile)
+{
+	std::lock_guard<std::mutex> locker{ _lock };
+	_live.push_back(profile);
+}
+
+inline void profile_registry::_remove(lock_profile* profile)
+{
+	std::lock_guard<std::mutex> locker{ _lock };
+	auto it = std::find(_live.begin(), _live.end(), profile);
+	if (it == _live.end())
+		return;
+	_live.erase(it);
+	profile->collect(_entry(_retired, profile->_name));
+}
+
+inline void profile_registry::_rename(lock_profile* profile, const char* name)
+{
+	std::lock_guard<std::mutex> locker{ _lock };
+	profile->_name = name;
+}
+
+/* Lockable(and SharedLockable if LockTy is) wrapper which records the profile of LockTy
+   The hold time is recorded for the exclusive ownership only, the shared owners count their acquisitions and waits. */
+template <class LockTy>
+class profiled
+{
+public:
+	using this_t = profiled<LockTy>;
+	using lock_t = LockTy;
+
+	profiled():
+		profiled("unnamed")
+	{
+	}
+	explicit profiled(const char* name):
+		_profile { name },
+		_acquired_at { 0 }
+	{
+	}
+	void lock()
+	{
+		if (_lock.try_lock())
+		{
+			_profile.record_acquire(false, 0);
+			_acquired_at = _now();
+			return;
+		}
+		const uint64_t begin = _now();
+		_lock.lock();
+		_acquired_at = _now();
+		_profile.record_acquire(true, _acquired_at - begin);
+	}
+	bool try_lock()
+	{
+		if (!_lock.try_lock())
+			return false;
+		_profile.record_acquire(false, 0);
+		_acquired_at = _now();
+		return true;
+	}
+	void unlock()
+	{
+		_profile.record_hold(_now() - _acquired_at);
+		_lock.unlock();
+	}
+	template <class L = LockTy>
+	auto lock_shared() -> decltype(std::declval<L&>().try_lock_shared(), std::declval<L&>().lock_shared())
+	{
+		if (_lock.try_lock_shared())
+		{
+			_profile.record_acquire(false, 0);
+			return;
+		}
+		const uint64_t begin = _now();
+		_lock.lock_shared();
+		_profile.record_acquire(true, _now() - begin);
+	}
+	template <class L = LockTy>
+	auto try_lock_shared() -> decltype(std::declval<L&>().try_lock_shared())
+	{
+		if (!_lock.try_lock_shared())
+			return false;
+		_profile.record_acquire(false, 0);
+		return true;
+	}
+	template <class L = LockTy>
+	auto unlock_shared() -> decltype(std::declval<L&>().unlock_shared())
+	{
+		_lock.unlock_shared();
+	}
+	void rename(const char* name)
+	{
+		_profile.rename(name);
+	}
+	lock_t& native()
+	{
+		return _lock;
+	}
+private:
+	static uint64_t _now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	lock_t _lock;
+	lock_profile _profile;
+	uint64_t _acquired_at; // written and read by the exclusive owner only
+
+	profiled(const profiled&) = delete;
+	void operator=(const profiled&) = delete;
+};
+
+} // !namespace lock
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCK_PROFILE_H_
@@ -1,21 +1,80 @@
 #ifndef _VEE_LOCKFREE_H_
 #define _VEE_LOCKFREE_H_
 
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
 namespace vee {
 
 namespace lockfree {
 
 namespace property {
 
+// Only one thread works on the side
 struct SingleCore
 {
 	
 };
 
+// Any number of threads work on the side
 struct MultiCore
 {
 	
 };
+
+// Producer/consumer cardinality of a lockfree container
+template <class ProducerTy, class ConsumerTy>
+struct concurrency
+{
+	using producer_t = ProducerTy;
+	using consumer_t = ConsumerTy;
+	static const bool multi_producer = std::is_same<ProducerTy, MultiCore>::value;
+	static const bool multi_consumer = std::is_same<ConsumerTy, MultiCore>::value;
+};
+
+using spsc = concurrency<SingleCore, SingleCore>;
+using mpsc = concurrency<MultiCore, SingleCore>;
+using spmc = concurrency<SingleCore, MultiCore>;
+using mpmc = concurrency<MultiCore, MultiCore>;
+
+// Swaps the producer and the consumer side (e.g. for a free-index ring which is filled by the consumers)
+template <class PolicyTy>
+using reversed = concurrency<typename PolicyTy::consumer_t, typename PolicyTy::producer_t>;
+
+// Ring layout: the capacity is kept as requested, and a position is wrapped with a modulo(integer division)
+struct exact_capacity
+{
+	static size_t round(size_t capacity)
+	{
+		return capacity;
+	}
+	static size_t wrap(uint64_t pos, size_t capacity)
+	{
+		return static_cast<size_t>(pos % capacity);
+	}
+};
+
+// Ring layout: the capacity is rounded up to a power of two, and a position is wrapped with a mask
+struct pow2_capacity
+{
+	static size_t round(size_t capacity)
+	{
+		if (capacity == 0)
+			return 0;
+		if (capacity > (SIZE_MAX >> 1) + 1)
+			throw std::invalid_argument("capacity cannot be rounded up to a power of two");
+		size_t rounded = 1;
+		while (rounded < capacity)
+			rounded <<= 1;
+		return rounded;
+	}
+	static size_t wrap(uint64_t pos, size_t capacity)
+	{
+		return static_cast<size_t>(pos & (capacity - 1));
+	}
+};
 	
 } // !namespace properties
 
@@ -23,4 +82,4 @@ struct MultiCore
 
 } // !namespace vee
 
-#endif // !_VEE_LOCKFREE_H_
\ No newline at end of file
+#endif // !_VEE_LOCKFREE_H_
@@ -0,0 +1,198 @@
+#ifndef _VEE_LOCKFREE_BLOCKING_H_
+#define _VEE_LOCKFREE_BLOCKING_H_
+
+#include <vee/lockfree/eventcount.h>
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/stack.h>
+#include <vee/lockfree/unbounded_queue.h>
+#include <vee/lockfree/mailbox.h>
+#include <vee/lockfree/work_stealing_deque.h>
+#include <chrono>
+#include <utility>
+
+namespace vee {
+
+namespace lockfree {
+
+// How the blocking adaptor puts into and takes from a container (enqueue/dequeue by default)
+template <class ContainerTy>
+struct blocking_traits
+{
+	using data_t = typename ContainerTy::data_t;
+	template <typename DataRef>
+	static bool put(ContainerTy& cont, DataRef&& value)
+	{
+		return cont.enqueue(std::forward<DataRef>(value));
+	}
+	static bool take(ContainerTy& cont, data_t& out)
+	{
+		return cont.dequeue(out);
+	}
+};
+
+template <typename DataTy, class PolicyTy, size_t EliminationSlots>
+struct blocking_traits<stack<DataTy, PolicyTy, EliminationSlots>>
+{
+	using container_t = stack<DataTy, PolicyTy, EliminationSlots>;
+	using data_t = DataTy;
+	template <typename DataRef>
+	static bool put(container_t& cont, DataRef&& value)
+	{
+		return cont.push(std::forward<DataRef>(value));
+	}
+	static bool take(container_t& cont, data_t& out)
+	{
+		return cont.pop(out);
+	}
+};
+
+template <class MessageTy>
+struct blocking_traits<mailbox<MessageTy>>
+{
+	using container_t = mailbox<MessageTy>;
+	using data_t = MessageTy*;
+	static bool put(container_t& cont, data_t msg)
+	{
+		cont.push(msg);
+		return true;
+	}
+	static bool take(container_t& cont, data_t& out)
+	{
+		out = cont.pop();
+		return out != nullptr;
+	}
+};
+
+// The owner puts, and the other threads steal
+template <typename DataTy, class ReclaimerTy>
+struct blocking_traits<work_stealing_deque<DataTy, ReclaimerTy>>
+{
+	using container_t = work_stealing_deque<DataTy, ReclaimerTy>;
+	using data_t = DataTy;
+	static bool put(container_t& cont, data_t value)
+	{
+		cont.push(value);
+		return true;
+	}
+	static bool take(container_t& cont, data_t& out)
+	{
+		return cont.steal(out);
+	}
+};
+
+/* Wraps a lockfree container with two eventcounts, so that the consumers(producers) can sleep
+   while the container is empty(full) instead of spinning.
+   The non-blocking calls stay lockfree and pay only a fence and a load for the notification while nobody waits.
+   The single-thread sides of the container policy apply to the waiting calls as well. */
+template <class ContainerTy, class TraitsTy = blocking_traits<ContainerTy>>
+class blocking final
+{
+public:
+	using this_t = blocking<ContainerTy, TraitsTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using container_t = ContainerTy;
+	using traits_t = TraitsTy;
+	using data_t = typename traits_t::data_t;
+	using steady_clock_t = std::chrono::steady_clock;
+
+	template <class ...Args>
+	explicit blocking(Args&& ...args):
+		_cont(std::forward<Args>(args)...)
+	{
+	}
+	template <typename DataRef>
+	bool enqueue(DataRef&& value)
+	{
+		if (!traits_t::put(_cont, std::forward<DataRef>(value)))
+			return false; // container is full
+		_not_empty.notify_one();
+		return true;
+	}
+	bool dequeue(data_t& out)
+	{
+		if (!traits_t::take(_cont, out))
+			return false; // container is empty
+		_not_full.notify_one();
+		return true;
+	}
+	// Sleeps while the container is full; a failed put leaves the value untouched, so every retry forwards it again
+	template <typename DataRef>
+	void enqueue_wait(DataRef&& value)
+	{
+		_wait(_not_full, [&]() { return traits_t::put(_cont, std::forward<DataRef>(value)); }, nullptr);
+		_not_empty.notify_one();
+	}
+	// Returns false if the container stayed full until the timeout
+	template <typename DataRef, class Rep, class Period>
+	bool enqueue_wait(DataRef&& value, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		steady_clock_t::time_point deadline = steady_clock_t::now() + std::chrono::duration_cast<steady_clock_t::duration>(timeout);
+		if (!_wait(_not_full, [&]() { return traits_t::put(_cont, std::forward<DataRef>(value)); }, &deadline))
+			return false;
+		_not_empty.notify_one();
+		return true;
+	}
+	// Sleeps while the container is empty
+	void dequeue_wait(data_t& out)
+	{
+		_wait(_not_empty, [&]() { return traits_t::take(_cont, out); }, nullptr);
+		_not_full.notify_one();
+	}
+	// Returns false if the container stayed empty until the timeout
+	template <class Rep, class Period>
+	bool dequeue_wait(data_t& out, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		steady_clock_t::time_point deadline = steady_clock_t::now() + std::chrono::duration_cast<steady_clock_t::duration>(timeout);
+		if (!_wait(_not_empty, [&]() { return traits_t::take(_cont, out); }, &deadline))
+			return false;
+		_not_full.notify_one();
+		return true;
+	}
+	// Wakes every waiting thread, e.g. before the shutdown of the consumers
+	void notify_all()
+	{
+		_not_empty.notify_all();
+		_not_full.notify_all();
+	}
+	// Direct access to the container, which does not notify the waiting threads
+	container_t& container()
+	{
+		return _cont;
+	}
+
+private:
+	template <class AttemptFn>
+	static bool _wait(eventcount& ec, AttemptFn&& attempt, const steady_clock_t::time_point* deadline)
+	{
+		while (!attempt())
+		{
+			eventcount::key_t key = ec.prepare_wait();
+			if (attempt())
+			{
+				ec.cancel_wait();
+				return true;
+			}
+			if (deadline == nullptr)
+				ec.commit_wait(key);
+			else if (!ec.commit_wait_until(key, *deadline))
+				return attempt();
+		}
+		return true;
+	}
+
+	container_t _cont;
+	eventcount _not_empty;
+	eventcount _not_full;
+
+	blocking(const ref_t) = delete;
+	blocking(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_BLOCKING_H_
@@ -0,0 +1,73 @@
+#ifndef _VEE_LOCKFREE_EBR_H_
+#define _VEE_LOCKFREE_EBR_H_
+
+#include <vee/core/noncopyable.h>
+#include <atomic>
+#include <cstddef>
+
+namespace vee {
+
+namespace lockfree {
+
+/* Epoch-based memory reclamation (K. Fraser)
+   A thread reads shared nodes only inside a guard, which publishes the global epoch in the thread's record.
+   The global epoch advances when every active record has observed it, so an object which was retired
+   at the epoch e cannot be referenced by anyone once the epoch reaches e + 2.
+   Retired objects are kept in a per-thread list and reclaimed in batches every reclaim_threshold retires.
+   Guards can be nested, and the scheme is shared by every container of the process. */
+class ebr
+{
+public:
+	using deleter_t = void(*)(void*);
+	static const size_t reclaim_threshold = 64;
+
+	class guard: noncopyable
+	{
+	public:
+		guard()
+		{
+			ebr::_enter();
+		}
+		~guard()
+		{
+			ebr::_leave();
+		}
+		// Loads a shared pointer which stays valid until the guard is destroyed
+		template <class T>
+		T* protect(const std::atomic<T*>& src, size_t /*slot*/ = 0) const
+		{
+			return src.load(std::memory_order_acquire);
+		}
+	};
+
+	// Hands an unlinked object over to the scheme, the deleter is called once no guard can reach it
+	static void retire(void* ptr, deleter_t deleter);
+	template <class T>
+	static void retire(T* ptr)
+	{
+		retire(ptr, &_delete<T>);
+	}
+	// Tries to advance the epoch and reclaims the calling thread's expired objects
+	static void flush();
+	// Blocks until every object retired by the calling thread is reclaimed (must not be called inside a guard)
+	static void synchronize();
+	// The number of objects which are retired but not reclaimed yet (process-wide)
+	static size_t guess_pending();
+
+private:
+	static void _enter();
+	static void _leave();
+	template <class T>
+	static void _delete(void* ptr)
+	{
+		delete static_cast<T*>(ptr);
+	}
+
+	ebr() = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_EBR_H_
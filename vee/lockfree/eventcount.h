@@ -0,0 +1,102 @@
+#ifndef _VEE_LOCKFREE_EVENTCOUNT_H_
+#define _VEE_LOCKFREE_EVENTCOUNT_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree/futex.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace vee {
+
+namespace lockfree {
+
+/* Eventcount: lets the consumers of a lockfree container sleep until a producer signals a change
+   A waiter announces itself with prepare_wait, checks its condition again, and then either
+   commits (sleeps until an epoch change) or cancels. A notifier first makes the condition true and
+   then calls notify, which costs a fence and a load while nobody waits.
+   The check between prepare_wait and commit_wait closes the window of a lost wakeup.
+
+   ex) while (!q.dequeue(out))
+       {
+           auto key = ec.prepare_wait();
+           if (q.dequeue(out)) { ec.cancel_wait(); break; }
+           ec.commit_wait(key);
+       } */
+class eventcount
+{
+public:
+	using key_t = uint32_t;
+
+	eventcount():
+		_epoch { 0 },
+		_waiters { 0 }
+	{
+	}
+	key_t prepare_wait()
+	{
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		return _epoch.load(std::memory_order_seq_cst);
+	}
+	void cancel_wait()
+	{
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+	// Sleeps until a notify which follows the prepare_wait
+	void commit_wait(key_t key)
+	{
+		while (_epoch.load(std::memory_order_acquire) == key)
+			futex::wait(_epoch, key);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+	// Returns false if the deadline passed first
+	bool commit_wait_until(key_t key, std::chrono::steady_clock::time_point deadline)
+	{
+		bool notified = true;
+		while (_epoch.load(std::memory_order_acquire) == key)
+		{
+			if (!futex::wait_until(_epoch, key, deadline))
+			{
+				notified = (_epoch.load(std::memory_order_acquire) != key);
+				break;
+			}
+		}
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+		return notified;
+	}
+	void notify_one()
+	{
+		if (_has_waiters())
+			futex::wake(_epoch, 1);
+	}
+	void notify_all()
+	{
+		if (_has_waiters())
+			futex::wake_all(_epoch);
+	}
+
+private:
+	bool _has_waiters()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_waiters.load(std::memory_order_relaxed) == 0)
+			return false;
+		_epoch.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+
+	std::atomic<uint32_t> _epoch;
+	std::atomic<uint32_t> _waiters;
+	char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>) * 2];
+
+	eventcount(const eventcount&) = delete;
+	eventcount(eventcount&&) = delete;
+	eventcount& operator=(const eventcount&) = delete;
+	eventcount& operator=(eventcount&&) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_EVENTCOUNT_H_
@@ -0,0 +1,32 @@
+#ifndef _VEE_LOCKFREE_FUTEX_H_
+#define _VEE_LOCKFREE_FUTEX_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace vee {
+
+namespace lockfree {
+
+/* Address-based wait and wake on a 32-bit atomic word
+   Linux uses the futex system call, other platforms emulate it with a table of condition variables
+   which are hashed by the address. The waiting thread does not consume any CPU time. */
+namespace futex {
+
+// Blocks while the word holds the expected value
+// (may return spuriously, the caller must check the word again)
+void wait(std::atomic<uint32_t>& word, uint32_t expected);
+// Returns false if the deadline passed first
+bool wait_until(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::steady_clock::time_point deadline);
+// Wakes up to the given number of threads which are waiting on the word
+void wake(std::atomic<uint32_t>& word, uint32_t count);
+void wake_all(std::atomic<uint32_t>& word);
+
+} // !namespace futex
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_FUTEX_H_
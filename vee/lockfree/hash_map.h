@@ -0,0 +1,427 @@
+#ifndef _VEE_LOCKFREE_HASH_MAP_H_
+#define _VEE_LOCKFREE_HASH_MAP_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree/ebr.h>
+#include <vee/lockfree/hazard_pointer.h>
+#include <vee/lockfree/uninitialized.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lockfree {
+
+/* Lockfree hash map on a split-ordered list (O. Shalev and N. Shavit)
+   Every element lives in a single lockfree linked list (M. Michael) sorted by the bit-reversed hash,
+   and a bucket is a dummy node inside the list. Doubling the bucket count therefore moves no element:
+   a new bucket is spliced into the list after its parent bucket by the first thread which needs it,
+   so a resize never stops the world. A thread which meets a bucket in the middle of the splice
+   starts from the parent bucket instead of waiting.
+   Find, insert and erase are lockfree; an erase marks the link of the node and unlinks it,
+   and the unlinked node is retired to the reclamation scheme(ebr or hazard_pointer).
+   The dummy nodes are kept in the bucket table itself, so a lookup costs no extra indirection.
+   The values are immutable while they are in the map, find copies the value out and
+   visit calls a function on it while the node is protected. */
+template <typename KeyTy, typename ValueTy, class HashTy = std::hash<KeyTy>, class KeyEqualTy = std::equal_to<KeyTy>, class ReclaimerTy = ebr>
+class hash_map final
+{
+public:
+	using this_t = hash_map<KeyTy, ValueTy, HashTy, KeyEqualTy, ReclaimerTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using key_t = KeyTy;
+	using mapped_t = ValueTy;
+	using hasher_t = HashTy;
+	using key_equal_t = KeyEqualTy;
+	using reclaimer_t = ReclaimerTy;
+	// The bucket count doubles when the number of elements exceeds bucket_count * max_load_factor
+	static const size_t max_load_factor = 2;
+
+	// The initial bucket count is rounded up to a power of two
+	explicit hash_map(size_t __initial_buckets = 64, const hasher_t& __hasher = hasher_t(), const key_equal_t& __key_equal = key_equal_t()):
+		_hasher { __hasher },
+		_key_equal { __key_equal },
+		_first_size { 1 },
+		_size { 0 },
+		_count { 0 }
+	{
+		while (_first_size < __initial_buckets)
+			_first_size <<= 1;
+		if (_first_size > _max_buckets())
+			throw std::invalid_argument("hash_map bucket count is out of range");
+		for (auto& it : _segments)
+			it.store(nullptr, std::memory_order_relaxed);
+		_size.store(_first_size, std::memory_order_relaxed);
+		bucket_t& first = _bucket_ref(0);
+		first.dummy.so_key = _dummy_key(0);
+		first.state.store(bucket_ready, std::memory_order_release);
+	}
+	~hash_map()
+	{
+		// The unlinked nodes belong to the reclamation scheme, the others are still in the list
+		link_t* link = _unmarked(_bucket_ref(0).dummy.next.load(std::memory_order_relaxed));
+		while (link)
+		{
+			link_t* next = _unmarked(link->next.load(std::memory_order_relaxed));
+			if (_is_element(link))
+				_delete_node(link);
+			link = next;
+		}
+		for (auto& it : _segments)
+			delete[] it.load(std::memory_order_relaxed);
+	}
+	// Returns false if the key is already in the map
+	template <typename ValueRef>
+	bool insert(const key_t& key, ValueRef&& value)
+	{
+		return emplace(key, std::forward<ValueRef>(value));
+	}
+	// Constructs the value from the arguments, returns false if the key is already in the map
+	template <class ...Args>
+	bool emplace(const key_t& key, Args&& ...args)
+	{
+		const size_t hash = _hasher(key);
+		node_t* node = _new_node(hash, key, std::forward<Args>(args)...);
+		{
+			typename reclaimer_t::guard guard;
+			link_t* bucket = _bucket(hash, guard);
+			window_t w;
+			while (true)
+			{
+				if (_find(bucket, node->so_key, &key, w, guard))
+				{
+					_delete_node(static_cast<link_t*>(node));
+					return false;
+				}
+				node->next.store(w.cur, std::memory_order_relaxed);
+				link_t* expected = w.cur;
+				if (w.prev->compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed))
+					break;
+			}
+		}
+		const size_t count = _count.fetch_add(1, std::memory_order_relaxed) + 1;
+		size_t size = _size.load(std::memory_order_relaxed);
+		if (count > size * max_load_factor && size < _max_buckets())
+			_size.compare_exchange_strong(size, size * 2, std::memory_order_relaxed);
+		return true;
+	}
+	// Copies the value of the key, returns false if the key is not in the map
+	bool find(const key_t& key, mapped_t& out)
+	{
+		return visit(key, [&out](const mapped_t& value) { out = value; });
+	}
+	bool contains(const key_t& key)
+	{
+		return visit(key, [](const mapped_t&) {});
+	}
+	// Calls fn(const mapped_t&) while the node of the key is protected, returns false if the key is not in the map
+	template <class VisitFn>
+	bool visit(const key_t& key, VisitFn&& fn)
+	{
+		const size_t hash = _hasher(key);
+		typename reclaimer_t::guard guard;
+		window_t w;
+		if (!_find(_bucket(hash, guard), _regular_key(hash), &key, w, guard))
+			return false;
+		fn(static_cast<const mapped_t&>(*static_cast<node_t*>(w.cur)->value));
+		return true;
+	}
+	// Returns false if the key is not in the map
+	bool erase(const key_t& key)
+	{
+		const size_t hash = _hasher(key);
+		const uint64_t so_key = _regular_key(hash);
+		typename reclaimer_t::guard guard;
+		link_t* bucket = _bucket(hash, guard);
+		window_t w;
+		while (true)
+		{
+			if (!_find(bucket, so_key, &key, w, guard))
+				return false;
+			link_t* next = w.cur->next.load(std::memory_order_acquire);
+			// Marking the link is the linearization point, a marked node is unlinked by whoever passes it
+			if (_is_marked(next) || !w.cur->next.compare_exchange_strong(next, _marked(next), std::memory_order_acq_rel))
+				continue;
+			_count.fetch_sub(1, std::memory_order_relaxed);
+			link_t* expected = w.cur;
+			if (w.prev->compare_exchange_strong(expected, next, std::memory_order_acq_rel))
+				_retire(w.cur);
+			else
+				_find(bucket, so_key, &key, w, guard);
+			return true;
+		}
+	}
+	size_t guess_size() const
+	{
+		return _count.load(std::memory_order_relaxed);
+	}
+	size_t bucket_count() const
+	{
+		return _size.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct link_t
+	{
+		std::atomic<link_t*> next; // the lowest bit marks the node as erased
+		uint64_t so_key;           // bit-reversed hash, odd for the elements and even for the dummy nodes
+	};
+
+	struct node_t: link_t
+	{
+		uninitialized<key_t> key;
+		uninitialized<mapped_t> value;
+	};
+
+	enum : uint32_t
+	{
+		bucket_empty = 0,
+		bucket_splicing,
+		bucket_ready
+	};
+
+	struct bucket_t
+	{
+		bucket_t():
+			state { bucket_empty }
+		{
+			dummy.next.store(nullptr, std::memory_order_relaxed);
+			dummy.so_key = 0;
+		}
+		link_t dummy;
+		std::atomic<uint32_t> state;
+	};
+
+	// The link which points to cur, and the first node whose key is not less than the requested one
+	struct window_t
+	{
+		std::atomic<link_t*>* prev;
+		link_t* cur;
+	};
+
+	static const size_t max_segments = sizeof(size_t) * 8;
+
+	static size_t _max_buckets()
+	{
+		return static_cast<size_t>(1) << (max_segments - 2);
+	}
+
+	static uint64_t _reverse(uint64_t bits)
+	{
+		bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+		bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+		bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+		bits = ((bits >> 8) & 0x00FF00FF00FF00FFULL) | ((bits & 0x00FF00FF00FF00FFULL) << 8);
+		bits = ((bits >> 16) & 0x0000FFFF0000FFFFULL) | ((bits & 0x0000FFFF0000FFFFULL) << 16);
+		return (bits >> 32) | (bits << 32);
+	}
+	static uint64_t _regular_key(size_t hash)
+	{
+		return _reverse(hash) | 1;
+	}
+	static uint64_t _dummy_key(size_t bucket)
+	{
+		return _reverse(bucket);
+	}
+	static bool _is_element(link_t* link)
+	{
+		return (link->so_key & 1) != 0;
+	}
+
+	static bool _is_marked(link_t* ptr)
+	{
+		return (reinterpret_cast<uintptr_t>(ptr) & 1) != 0;
+	}
+	static link_t* _marked(link_t* ptr)
+	{
+		return reinterpret_cast<link_t*>(reinterpret_cast<uintptr_t>(ptr) | 1);
+	}
+	static link_t* _unmarked(link_t* ptr)
+	{
+		return reinterpret_cast<link_t*>(reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(1));
+	}
+
+	template <class ...Args>
+	static node_t* _new_node(size_t hash, const key_t& key, Args&& ...args)
+	{
+		node_t* node = new node_t;
+		node->next.store(nullptr, std::memory_order_relaxed);
+		node->so_key = _regular_key(hash);
+		try
+		{
+			node->key.construct(key);
+		}
+		catch (...)
+		{
+			delete node;
+			throw;
+		}
+		try
+		{
+			node->value.construct(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			node->key.destroy();
+			delete node;
+			throw;
+		}
+		return node;
+	}
+	// Deleter of the element nodes, which are passed around as links
+	static void _delete_node(void* ptr)
+	{
+		node_t* node = static_cast<node_t*>(static_cast<link_t*>(ptr));
+		node->key.destroy();
+		node->value.destroy();
+		delete node;
+	}
+	static void _retire(link_t* link)
+	{
+		reclaimer_t::retire(static_cast<void*>(link), &_delete_node);
+	}
+
+	/* Searches the list from the dummy node start (Michael's list search)
+	   The marked nodes on the way are unlinked and retired, and the search restarts when a link changes under it.
+	   The guard slots rotate between prev, cur and next, so that cur and the node of prev stay protected on return. */
+	bool _find(link_t* start, uint64_t so_key, const key_t* key, window_t& w, typename reclaimer_t::guard& guard)
+	{
+		while (true)
+		{
+			size_t prev_slot = 0, cur_slot = 1, next_slot = 2;
+			std::atomic<link_t*>* prev = &start->next;
+			link_t* cur = guard.protect(*prev, cur_slot);
+			while (true)
+			{
+				if (cur == nullptr)
+				{
+					w.prev = prev;
+					w.cur = nullptr;
+					return false;
+				}
+				link_t* next = guard.protect(cur->next, next_slot);
+				if (prev->load(std::memory_order_acquire) != cur)
+					break; // the link has changed, restart from the dummy node
+				if (!_is_marked(next))
+				{
+					if (cur->so_key > so_key)
+					{
+						w.prev = prev;
+						w.cur = cur;
+						return false;
+					}
+					if (cur->so_key == so_key && (key == nullptr || _key_equal(*static_cast<node_t*>(cur)->key, *key)))
+					{
+						w.prev = prev;
+						w.cur = cur;
+						return true;
+					}
+					prev = &cur->next;
+					size_t free_slot = prev_slot;
+					prev_slot = cur_slot;
+					cur_slot = next_slot;
+					next_slot = free_slot;
+				}
+				else
+				{
+					link_t* expected = cur;
+					if (!prev->compare_exchange_strong(expected, _unmarked(next), std::memory_order_acq_rel))
+						break;
+					_retire(cur);
+					std::swap(cur_slot, next_slot);
+				}
+				cur = _unmarked(next);
+			}
+		}
+	}
+
+	// The dummy node to start a search for the hash from
+	link_t* _bucket(size_t hash, typename reclaimer_t::guard& guard)
+	{
+		return _bucket_at(hash & (_size.load(std::memory_order_relaxed) - 1), guard);
+	}
+	link_t* _bucket_at(size_t index, typename reclaimer_t::guard& guard)
+	{
+		bucket_t& bucket = _bucket_ref(index);
+		if (bucket.state.load(std::memory_order_acquire) == bucket_ready)
+			return &bucket.dummy;
+		// The parent bucket is the one without the highest bit, its dummy node precedes the new one
+		size_t parent = index;
+		for (size_t bit = 1; bit <= index; bit <<= 1)
+		{
+			if (index & bit)
+				parent = index & ~bit;
+		}
+		link_t* start = _bucket_at(parent, guard);
+		uint32_t state = bucket_empty;
+		if (!bucket.state.compare_exchange_strong(state, bucket_splicing, std::memory_order_acquire))
+			return (state == bucket_ready) ? &bucket.dummy : start; // another thread is splicing it
+		bucket.dummy.so_key = _dummy_key(index);
+		window_t w;
+		while (true)
+		{
+			_find(start, bucket.dummy.so_key, nullptr, w, guard);
+			bucket.dummy.next.store(w.cur, std::memory_order_relaxed);
+			link_t* expected = w.cur;
+			if (w.prev->compare_exchange_strong(expected, &bucket.dummy, std::memory_order_release, std::memory_order_relaxed))
+				break;
+		}
+		bucket.state.store(bucket_ready, std::memory_order_release);
+		return &bucket.dummy;
+	}
+
+	// The bucket table is a directory of segments which double in size, allocated on the first use
+	bucket_t& _bucket_ref(size_t index)
+	{
+		size_t seg = 0, offset = index, length = _first_size;
+		if (index >= _first_size)
+		{
+			seg = 1;
+			while (index >= length * 2)
+			{
+				length *= 2;
+				++seg;
+			}
+			offset = index - length;
+		}
+		bucket_t* segment = _segments[seg].load(std::memory_order_acquire);
+		if (segment == nullptr)
+		{
+			bucket_t* fresh = new bucket_t[length];
+			if (_segments[seg].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel))
+				segment = fresh;
+			else
+				delete[] fresh;
+		}
+		return segment[offset];
+	}
+
+	hasher_t _hasher;
+	key_equal_t _key_equal;
+	size_t _first_size;
+	std::atomic<bucket_t*> _segments[max_segments];
+	char _pad0[VEE_CACHE_LINE_SIZE];
+	std::atomic<size_t> _size;  // bucket count, a power of two
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> _count; // element count
+	char _pad2[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+	hash_map(const ref_t) = delete;
+	hash_map(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCKFREE_HASH_MAP_H_
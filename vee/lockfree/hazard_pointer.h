@@ -0,0 +1,96 @@
+#ifndef _VEE_LOCKFREE_HAZARD_POINTER_H_
+#define _VEE_LOCKFREE_HAZARD_POINTER_H_
+
+#include <vee/core/noncopyable.h>
+#include <atomic>
+#include <cstddef>
+
+namespace vee {
+
+namespace lockfree {
+
+/* Hazard-pointer memory reclamation (M. Michael)
+   A thread publishes every shared node it is about to dereference in one of its hazard slots,
+   and a retired object is reclaimed only when no slot of any thread points to it.
+   A blocked reader therefore holds back only the objects it has published, unlike ebr.
+   Retired objects are kept in a per-thread list which is scanned whenever it reaches scan_threshold,
+   so a thread holds back at most scan_threshold objects plus the ones published in the slots of all threads.
+   A published pointer may carry a mark in its lowest bit(e.g. a logically deleted list link), the scan ignores the bit.
+   The interface is the same as ebr's, so the containers take either of them as a reclaimer parameter. */
+class hazard_pointer
+{
+public:
+	using deleter_t = void(*)(void*);
+	static const size_t slots_per_thread = 4;
+	static const size_t scan_threshold = 64;
+
+	// Clears the slots which were set through the guard when it is destroyed
+	// (nested guards of the same thread must use different slots)
+	class guard: noncopyable
+	{
+	public:
+		guard():
+			_slots { hazard_pointer::_local_slots() },
+			_used { 0 }
+		{
+		}
+		~guard()
+		{
+			for (size_t i = 0; _used; ++i, _used >>= 1)
+			{
+				if (_used & 1)
+					_slots[i].store(nullptr, std::memory_order_release);
+			}
+		}
+		// Loads a shared pointer and publishes it in the given slot,
+		// the object stays valid until the slot is overwritten or the guard is destroyed
+		template <class T>
+		T* protect(const std::atomic<T*>& src, size_t slot = 0)
+		{
+			_used |= static_cast<size_t>(1) << slot;
+			T* ptr = src.load(std::memory_order_relaxed);
+			while (true)
+			{
+				_slots[slot].store(ptr, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				T* again = src.load(std::memory_order_acquire);
+				if (again == ptr)
+					return ptr;
+				ptr = again;
+			}
+		}
+	private:
+		std::atomic<void*>* _slots;
+		size_t _used;
+	};
+
+	// Hands an unlinked object over to the scheme, the deleter is called once no slot points to it
+	static void retire(void* ptr, deleter_t deleter);
+	template <class T>
+	static void retire(T* ptr)
+	{
+		retire(ptr, &_delete<T>);
+	}
+	// Scans the hazard slots and reclaims the calling thread's unprotected objects
+	static void flush();
+	// Blocks until every object retired by the calling thread is reclaimed (must not be called inside a guard)
+	static void synchronize();
+	// The number of objects which are retired but not reclaimed yet (process-wide)
+	static size_t guess_pending();
+
+private:
+	static std::atomic<void*>* _local_slots();
+	template <class T>
+	static void _delete(void* ptr)
+	{
+		delete static_cast<T*>(ptr);
+	}
+
+	hazard_pointer() = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_HAZARD_POINTER_H_
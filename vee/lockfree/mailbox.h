@@ -0,0 +1,125 @@
+#ifndef _VEE_LOCKFREE_MAILBOX_H_
+#define _VEE_LOCKFREE_MAILBOX_H_
+
+#include <vee/platform.h>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+namespace vee {
+
+namespace lockfree {
+
+// Embedded in (derived by) the messages of a mailbox
+struct mailbox_hook
+{
+	std::atomic<mailbox_hook*> next;
+};
+
+/* Intrusive MPSC mailbox for the actor-style consumers
+   A producer links its message with a single exchange on the head (wait-free, as Vyukov's intrusive queue),
+   and the consumer detaches every pending message with a single exchange, reverses them into FIFO order
+   and hands them out from its private list, so neither side allocates or copies a message.
+   The messages are owned by the caller and must stay alive until the consumer has taken them.
+   A producer which is preempted between its exchange and its link holds the consumer back
+   until the link is stored (usually a few instructions). */
+template <class MessageTy>
+class mailbox final
+{
+public:
+	using this_t = mailbox<MessageTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using message_t = MessageTy;
+	static_assert(std::is_base_of<mailbox_hook, message_t>::value, "message type of mailbox must derive from mailbox_hook");
+
+	mailbox():
+		_head { nullptr },
+		_local { nullptr }
+	{
+	}
+	~mailbox() = default;
+	// Any thread
+	void push(message_t* msg)
+	{
+		mailbox_hook* hook = msg;
+		hook->next.store(_unlinked(), std::memory_order_relaxed);
+		mailbox_hook* prev = _head.exchange(hook, std::memory_order_acq_rel);
+		hook->next.store(prev, std::memory_order_release);
+	}
+	// Consumer only, returns nullptr if the mailbox is empty
+	message_t* pop()
+	{
+		if (_local == nullptr)
+			_local = _detach();
+		mailbox_hook* hook = _local;
+		if (hook)
+			_local = hook->next.load(std::memory_order_relaxed);
+		return static_cast<message_t*>(hook);
+	}
+	// Consumer only, calls fn(message_t*) for every pending message in FIFO order and returns the number of them
+	template <class Fn>
+	size_t drain(Fn&& fn)
+	{
+		mailbox_hook* hook = _local;
+		_local = nullptr;
+		if (hook == nullptr)
+			hook = _detach();
+		size_t count = 0;
+		while (hook)
+		{
+			mailbox_hook* next = hook->next.load(std::memory_order_relaxed);
+			fn(static_cast<message_t*>(hook));
+			hook = next;
+			++count;
+		}
+		return count;
+	}
+	bool empty() const
+	{
+		return _local == nullptr && _head.load(std::memory_order_relaxed) == nullptr;
+	}
+
+private:
+	// Marks a message which is published on the head but not linked to its predecessor yet
+	static mailbox_hook* _unlinked()
+	{
+		static mailbox_hook mark;
+		return &mark;
+	}
+
+	// Takes every pushed message with one exchange, and returns them from the oldest
+	mailbox_hook* _detach()
+	{
+		mailbox_hook* hook = _head.exchange(nullptr, std::memory_order_acquire);
+		mailbox_hook* reversed = nullptr;
+		while (hook)
+		{
+			mailbox_hook* prev = hook->next.load(std::memory_order_acquire);
+			while (prev == _unlinked())
+			{
+				std::this_thread::yield();
+				prev = hook->next.load(std::memory_order_acquire);
+			}
+			hook->next.store(reversed, std::memory_order_relaxed);
+			reversed = hook;
+			hook = prev;
+		}
+		return reversed;
+	}
+
+	std::atomic<mailbox_hook*> _head;
+	char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<mailbox_hook*>)];
+	mailbox_hook* _local; // consumer's private FIFO list
+
+	mailbox(const ref_t) = delete;
+	mailbox(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_MAILBOX_H_
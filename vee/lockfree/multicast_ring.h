@@ -0,0 +1,362 @@
+#ifndef _VEE_LOCKFREE_MULTICAST_RING_H_
+#define _VEE_LOCKFREE_MULTICAST_RING_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree.h>
+#include <vee/lockfree/eventcount.h>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lockfree {
+
+// How the threads of a multicast_ring wait for new entries or for free slots
+namespace wait_strategy {
+
+// Spins on the sequences: the lowest latency, but every waiting thread keeps a core busy
+struct busy_spin
+{
+	template <class ReadyFn>
+	void wait_for(ReadyFn&& ready)
+	{
+		while (!ready());
+	}
+	void signal()
+	{
+	}
+};
+
+// Spins for a while, then gives the core away between the checks
+struct yield
+{
+	template <class ReadyFn>
+	void wait_for(ReadyFn&& ready)
+	{
+		for (size_t spins = 0; !ready(); ++spins)
+		{
+			if (spins >= 64)
+				std::this_thread::yield();
+		}
+	}
+	void signal()
+	{
+	}
+};
+
+// Spins for a while, then sleeps on an eventcount until a producer publishes or a consumer moves on
+class block
+{
+public:
+	template <class ReadyFn>
+	void wait_for(ReadyFn&& ready)
+	{
+		for (size_t spins = 0; spins < 64; ++spins)
+		{
+			if (ready())
+				return;
+		}
+		while (!ready())
+		{
+			eventcount::key_t key = _ec.prepare_wait();
+			if (ready())
+			{
+				_ec.cancel_wait();
+				return;
+			}
+			_ec.commit_wait(key);
+		}
+	}
+	void signal()
+	{
+		_ec.notify_all();
+	}
+private:
+	eventcount _ec;
+};
+
+} // !namespace wait_strategy
+
+/* Disruptor-style multicast ring
+   Every entry which is published once is seen by every consumer in the order of publication:
+   the slots are allocated up front and the consumers read them in place, so a fan-out costs no copy
+   and no queue per consumer. Each consumer keeps its own sequence(the number of entries it has finished),
+   and a producer waits while the slowest consumer is a full ring behind.
+   A consumer can depend on other consumers and then sees only the entries which all of them have finished,
+   so a pipeline stage may update an entry for the following stages.
+   The producers claim and publish batches, and the consumers take every available entry(up to a limit) at once.
+   ProducerTy is property::SingleCore or property::MultiCore, WaitTy is one of wait_strategy.
+   The consumers must be subscribed before the producers start.
+
+   ex) auto& journal = ring.subscribe();
+       auto& replicate = ring.subscribe();
+       auto& apply = ring.subscribe({ &journal, &replicate });
+       size_t seq = ring.claim(); ring[seq] = msg; ring.publish(seq);
+       apply.consume([](message_t& msg, size_t seq) { ... }); */
+template <typename DataTy, class ProducerTy = property::SingleCore, class WaitTy = wait_strategy::yield>
+class multicast_ring final
+{
+public:
+	using this_t = multicast_ring<DataTy, ProducerTy, WaitTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	using wait_t = WaitTy;
+	static const bool multi_producer = std::is_same<ProducerTy, property::MultiCore>::value;
+
+	class consumer
+	{
+	public:
+		// Waits for at least one entry, passes up to max_batch entries to fn(data_t&, size_t seq),
+		// and returns the number of the entries
+		template <class Fn>
+		size_t consume(Fn&& fn, size_t max_batch = SIZE_MAX)
+		{
+			size_t count = 0;
+			_ring._waiter.wait_for([&]() { return (count = _available(max_batch)) != 0; });
+			return _consume(fn, count);
+		}
+		// Returns 0 without waiting if no entry is available
+		template <class Fn>
+		size_t try_consume(Fn&& fn, size_t max_batch = SIZE_MAX)
+		{
+			const size_t count = _available(max_batch);
+			return (count) ? _consume(fn, count) : 0;
+		}
+		// The number of the entries which this consumer has finished
+		size_t sequence() const
+		{
+			return _seq.load(std::memory_order_acquire);
+		}
+
+	private:
+		friend class multicast_ring<DataTy, ProducerTy, WaitTy>;
+		consumer(ref_t ring, std::vector<const consumer*>&& deps, size_t start):
+			_ring { ring },
+			_deps { std::move(deps) },
+			_next { start },
+			_seq { start }
+		{
+		}
+
+		size_t _available(size_t max_batch) const
+		{
+			size_t end = 0;
+			if (!_deps.empty())
+			{
+				// The dependencies only finish the published entries
+				end = _deps[0]->_seq.load(std::memory_order_acquire);
+				for (size_t i = 1; i < _deps.size(); ++i)
+				{
+					const size_t seq = _deps[i]->_seq.load(std::memory_order_acquire);
+					if (seq - _next < end - _next)
+						end = seq;
+				}
+			}
+			else if (!multi_producer)
+			{
+				end = _ring._cursor.load(std::memory_order_acquire);
+			}
+			else
+			{
+				// The producers may publish out of order, so only the gapless run of published slots counts
+				const size_t claimed = _ring._claim.load(std::memory_order_acquire);
+				const size_t limit = _next + std::min(claimed - _next, max_batch);
+				for (end = _next; end != limit && _ring._published[_ring._wrap(end)].load(std::memory_order_acquire) == end + 1; ++end);
+			}
+			return std::min(end - _next, max_batch);
+		}
+
+		template <class Fn>
+		size_t _consume(Fn& fn, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				fn(_ring._slots[_ring._wrap(_next + i)], _next + i);
+			_next += count;
+			_seq.store(_next, std::memory_order_release);
+			_ring._waiter.signal();
+			return count;
+		}
+
+		ref_t _ring;
+		const std::vector<const consumer*> _deps;
+		size_t _next;
+		char _pad0[VEE_CACHE_LINE_SIZE];
+		std::atomic<size_t> _seq;
+		char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+		consumer(const consumer&) = delete;
+		void operator=(const consumer&) = delete;
+	};
+
+	explicit multicast_ring(size_t __capacity):
+		capacity { property::pow2_capacity::round(__capacity) },
+		_claim { 0 },
+		_gate_cache { 0 },
+		_cursor { 0 }
+	{
+		if (capacity == 0)
+			throw std::invalid_argument("multicast_ring capacity must be greater than zero");
+		_slots = new data_t[capacity];
+		if (multi_producer)
+		{
+			_published = new std::atomic<size_t>[capacity];
+			for (size_t i = 0; i < capacity; ++i)
+				_published[i].store(0, std::memory_order_relaxed);
+		}
+	}
+	~multicast_ring()
+	{
+		delete[] _slots;
+		delete[] _published;
+	}
+	// Adds a consumer which starts at the current end of the ring
+	// and sees only the entries which all of the dependencies have finished
+	consumer& subscribe(std::initializer_list<const consumer*> dependencies = {})
+	{
+		std::vector<const consumer*> deps{ dependencies };
+		for (const consumer* dep : deps)
+		{
+			if (&dep->_ring != this)
+				throw std::invalid_argument("multicast_ring dependency belongs to another ring");
+		}
+		const size_t start = _claim.load(std::memory_order_acquire);
+		_consumers.emplace_back(new consumer(*this, std::move(deps), start));
+		consumer* added = _consumers.back().get();
+		// Only the ends of the chains gate the producers
+		for (const consumer* dep : added->_deps)
+			_gating.erase(std::remove(_gating.begin(), _gating.end(), dep), _gating.end());
+		_gating.push_back(added);
+		return *added;
+	}
+	// Claims count consecutive slots and returns the sequence of the first one,
+	// waits while the slowest consumer is too far behind
+	size_t claim(size_t count = 1)
+	{
+		_check_batch(count);
+		size_t first = 0;
+		if (multi_producer)
+			first = _claim.fetch_add(count, std::memory_order_relaxed);
+		else
+		{
+			first = _claim.load(std::memory_order_relaxed);
+			_claim.store(first + count, std::memory_order_relaxed);
+		}
+		if (!_has_space(first + count))
+			_waiter.wait_for([&]() { return _has_space(first + count); });
+		return first;
+	}
+	// Returns false without waiting if the ring has no room for count slots
+	bool try_claim(size_t& first, size_t count = 1)
+	{
+		_check_batch(count);
+		size_t claimed = _claim.load(std::memory_order_relaxed);
+		do
+		{
+			if (!_has_space(claimed + count))
+				return false;
+		} while (!_try_advance(claimed, count));
+		first = claimed;
+		return true;
+	}
+	// The slot of a claimed sequence, valid until the sequence is published
+	data_t& operator[](size_t seq)
+	{
+		return _slots[_wrap(seq)];
+	}
+	// Makes the claimed slots visible to the consumers
+	void publish(size_t first, size_t count = 1)
+	{
+		if (multi_producer)
+		{
+			for (size_t i = 0; i < count; ++i)
+				_published[_wrap(first + i)].store(first + i + 1, std::memory_order_release);
+		}
+		else
+		{
+			_cursor.store(first + count, std::memory_order_release);
+		}
+		_waiter.signal();
+	}
+	// Claims a slot, assigns the value and publishes it
+	template <typename DataRef>
+	void push(DataRef&& value)
+	{
+		const size_t seq = claim();
+		_slots[_wrap(seq)] = std::forward<DataRef>(value);
+		publish(seq);
+	}
+
+	const size_t capacity;
+private:
+	inline size_t _wrap(size_t seq) const
+	{
+		return property::pow2_capacity::wrap(seq, capacity);
+	}
+
+	void _check_batch(size_t count) const
+	{
+		if (count == 0 || count > capacity)
+			throw std::invalid_argument("multicast_ring batch is out of range");
+	}
+
+	bool _try_advance(size_t& claimed, size_t count)
+	{
+		if (multi_producer)
+			return _claim.compare_exchange_weak(claimed, claimed + count, std::memory_order_relaxed);
+		_claim.store(claimed + count, std::memory_order_relaxed);
+		return true;
+	}
+
+	// True if every gating consumer has finished the sequence which the end of the claim overwrites
+	bool _has_space(size_t end)
+	{
+		const size_t wrap_point = end - capacity;
+		// The cache passes on what the producer which filled it has seen of the consumers, hence acquire and release
+		size_t gate = _gate_cache.load(std::memory_order_acquire);
+		if (static_cast<ptrdiff_t>(wrap_point - gate) <= 0)
+			return true;
+		gate = end;
+		for (const consumer* it : _gating)
+		{
+			const size_t seq = it->_seq.load(std::memory_order_acquire);
+			if (static_cast<ptrdiff_t>(seq - gate) < 0)
+				gate = seq;
+		}
+		_gate_cache.store(gate, std::memory_order_release);
+		return static_cast<ptrdiff_t>(wrap_point - gate) <= 0;
+	}
+
+	data_t* _slots = nullptr;
+	std::atomic<size_t>* _published = nullptr;
+	std::vector<std::unique_ptr<consumer>> _consumers;
+	std::vector<const consumer*> _gating;
+	char _pad0[VEE_CACHE_LINE_SIZE];
+	std::atomic<size_t> _claim;
+	std::atomic<size_t> _gate_cache;
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) * 2];
+	std::atomic<size_t> _cursor;
+	char _pad2[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+	wait_t _waiter;
+
+	multicast_ring(const ref_t) = delete;
+	multicast_ring(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCKFREE_MULTICAST_RING_H_
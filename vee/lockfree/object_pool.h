@@ -0,0 +1,261 @@
+#ifndef _VEE_LOCKFREE_OBJECT_POOL_H_
+#define _VEE_LOCKFREE_OBJECT_POOL_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree/stack.h>
+#include <vee/lockfree/uninitialized.h>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lockfree {
+
+/* Fixed-capacity pool of objects with per-thread caches
+   The blocks are allocated once, and the free block indices are kept in a shared index_stack.
+   Every thread keeps up to 2 * BatchSize free indices of the pool in its own cache:
+   an acquire or a release touches only the cache, an empty cache takes up to BatchSize indices
+   from the shared freelist and a full cache gives BatchSize indices back, each with a single CAS.
+   So the steady state never calls malloc and rarely touches the shared freelist.
+   A thread's cache is returned to the freelist when the thread exits.
+
+   Objects which sit in the caches of the other threads are not visible to an acquire,
+   so the capacity should cover the objects in use plus 2 * BatchSize for each thread.
+   An object must be released before the pool is destroyed. */
+template <typename DataTy, size_t BatchSize = 32>
+class object_pool final
+{
+	struct core_t;
+public:
+	using this_t = object_pool<DataTy, BatchSize>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	static const size_t batch_size = BatchSize;
+	static_assert(BatchSize > 0, "batch size must be greater than zero");
+
+	// Owns an object of the pool and returns it on destruction
+	class handle
+	{
+	public:
+		handle() = default;
+		handle(handle&& other):
+			_pool { other._pool },
+			_ptr { other._ptr }
+		{
+			other._ptr = nullptr;
+		}
+		handle& operator=(handle&& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				_pool = other._pool;
+				_ptr = other._ptr;
+				other._ptr = nullptr;
+			}
+			return *this;
+		}
+		~handle()
+		{
+			reset();
+		}
+		// Destroys the object and returns it to the pool
+		void reset()
+		{
+			if (_ptr == nullptr)
+				return;
+			_pool->destroy(_ptr);
+			_ptr = nullptr;
+		}
+		data_t* get() const
+		{
+			return _ptr;
+		}
+		data_t& operator*() const
+		{
+			return *_ptr;
+		}
+		data_t* operator->() const
+		{
+			return _ptr;
+		}
+		// False if the pool was exhausted
+		explicit operator bool() const
+		{
+			return _ptr != nullptr;
+		}
+
+	private:
+		friend class object_pool<DataTy, BatchSize>;
+		handle(this_t* pool, data_t* ptr):
+			_pool { pool },
+			_ptr { ptr }
+		{
+		}
+
+		this_t* _pool = nullptr;
+		data_t* _ptr = nullptr;
+
+		handle(const handle&) = delete;
+		handle& operator=(const handle&) = delete;
+	};
+
+	explicit object_pool(size_t __capacity):
+		capacity { __capacity },
+		_core { new core_t(__capacity) }
+	{
+	}
+	~object_pool()
+	{
+		// The threads which still cache indices of the pool drop their caches lazily
+		_core->closed.store(true, std::memory_order_release);
+		_release(_core);
+	}
+	// Constructs an object from the arguments, the handle is empty if the pool is exhausted
+	template <class ...Args>
+	handle acquire(Args&& ...args)
+	{
+		return handle{ this, create(std::forward<Args>(args)...) };
+	}
+	// Raw interface for the owners which cannot keep a handle, returns nullptr if the pool is exhausted
+	template <class ...Args>
+	data_t* create(Args&& ...args)
+	{
+		cache_t& cache = _local_cache();
+		if (cache.count == 0 && !_refill(cache))
+			return nullptr; // pool is exhausted
+		uninitialized<data_t>& block = _core->blocks[cache.items[cache.count - 1]];
+		block.construct(std::forward<Args>(args)...);
+		--cache.count; // the index stays in the cache if the constructor throws
+		return &block.get();
+	}
+	// Destroys an object which was created by this pool, on any thread
+	void destroy(data_t* ptr)
+	{
+		const index_t idx = _index_of(ptr);
+		ptr->~data_t();
+		cache_t& cache = _local_cache();
+		if (cache.count == cache_size)
+		{
+			cache.count -= batch_size;
+			_core->freelist.push_chain(cache.items + cache.count, batch_size);
+		}
+		cache.items[cache.count++] = idx;
+	}
+
+	const size_t capacity;
+private:
+	using index_t = index_stack::index_t;
+	static const size_t cache_size = BatchSize * 2;
+
+	// Shared by the pool and the thread caches, deleted by whoever drops the last reference
+	struct core_t
+	{
+		explicit core_t(size_t capacity):
+			blocks { new uninitialized<data_t>[capacity] },
+			freelist { capacity, true }
+		{
+		}
+		~core_t()
+		{
+			delete[] blocks;
+		}
+		uninitialized<data_t>* blocks;
+		index_stack freelist;
+		std::atomic<size_t> refs { 1 };
+		std::atomic<bool> closed { false };
+	};
+
+	struct cache_t
+	{
+		core_t* core;
+		size_t count;
+		index_t items[cache_size];
+	};
+
+	// The caches of a thread, one for each pool which the thread has used
+	struct local_t
+	{
+		std::vector<cache_t*> caches;
+		~local_t()
+		{
+			for (cache_t* it : caches)
+				_drop(it);
+		}
+	};
+
+	static void _drop(cache_t* cache)
+	{
+		cache->core->freelist.push_chain(cache->items, cache->count);
+		_release(cache->core);
+		delete cache;
+	}
+
+	static void _release(core_t* core)
+	{
+		if (core->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete core;
+	}
+
+	cache_t& _local_cache()
+	{
+		static thread_local local_t local;
+		std::vector<cache_t*>& caches = local.caches;
+		if (!caches.empty() && caches.front()->core == _core)
+			return *caches.front();
+		for (size_t i = 0; i < caches.size(); ++i)
+		{
+			if (caches[i]->core->closed.load(std::memory_order_acquire))
+			{
+				// The pool was destroyed, give up its cache
+				_drop(caches[i]);
+				caches[i--] = caches.back();
+				caches.pop_back();
+			}
+			else if (caches[i]->core == _core)
+			{
+				std::swap(caches[i], caches.front());
+				return *caches.front();
+			}
+		}
+		cache_t* cache = new cache_t;
+		cache->core = _core;
+		cache->count = 0;
+		_core->refs.fetch_add(1, std::memory_order_relaxed);
+		caches.push_back(cache);
+		std::swap(caches.back(), caches.front());
+		return *cache;
+	}
+
+	bool _refill(cache_t& cache)
+	{
+		cache.count += _core->freelist.pop_chain(cache.items + cache.count, batch_size - cache.count);
+		return cache.count != 0;
+	}
+
+	index_t _index_of(data_t* ptr) const
+	{
+		return static_cast<index_t>(reinterpret_cast<uninitialized<data_t>*>(ptr) - _core->blocks);
+	}
+
+	core_t* _core;
+
+	object_pool(const ref_t) = delete;
+	object_pool(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCKFREE_OBJECT_POOL_H_
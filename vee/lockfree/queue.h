@@ -1,8 +1,17 @@
 #ifndef _VEE_LOCKFREE_QUEUE_H_
 #define _VEE_LOCKFREE_QUEUE_H_
 
+#include <vee/platform.h>
+#include <vee/lockfree.h>
+#include <vee/mpl.h>
+#include <vee/telemetry.h>
+#include <vee/lockfree/uninitialized.h>
+#include <vee/lockfree/stress.h>
 #include <stdexcept>
 #include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <iterator>
 
 #pragma warning(disable:4127)
 
@@ -10,93 +19,385 @@ namespace vee {
 
 namespace lockfree {
 
-template <typename DataTy>
-class atqueue
+/* Bounded MPMC ring buffer (D. Vyukov)
+   Every slot carries a sequence number that tells who owns the slot in the current lap.
+   seq == pos * 2     : the slot is free for the producer which claims the position pos
+   seq == pos * 2 + 1 : the slot is filled for the consumer which claims the position pos
+   (doubled so that a full slot of the previous lap never aliases a free one, even at capacity 1)
+   A position is claimed with a single CAS on _rear(_front), and the slot is published
+   to the other side with a release store of the next sequence number.
+   A side which is declared SingleCore by the policy claims its position with a plain store.
+   The slots are raw storage, an element is constructed in place by the producer and destroyed by the consumer.
+   The element is constructed only after the slot has been claimed, so a full ring never touches the arguments.
+   If the constructor throws, the claimed slot is still published, as a dead slot which the consumers skip.
+   If the assignment(or the construction) into the consumer's storage throws, the element is destroyed and
+   its slot released before the exception leaves, so the element is lost but the ring stays usable.
+   The layout policy decides how a position is wrapped into the ring: property::pow2_capacity rounds
+   the capacity up to a power of two and replaces the integer division of every index with a mask.
+   The positions are 64-bit on every platform: a 32-bit position would wrap after 2^32 operations, and with
+   an exact capacity which does not divide 2^32 the wrapped slot index and the sequence numbers would jump.
+   The read-only members, _rear and _front are kept on separate cache lines.
+   The contention counters(vee/telemetry.h) are compiled in with VEE_TELEMETRY. */
+template <typename DataTy, class PolicyTy = property::mpmc, class LayoutTy = property::exact_capacity>
+class atqueue: private telemetry::recorder_t
 {
 public:
-	using this_t = atqueue<DataTy>;
+	using this_t = atqueue<DataTy, PolicyTy, LayoutTy>;
 	using ref_t = this_t&;
 	using rref_t = this_t&&;
 	using data_t = DataTy;
+	using policy_t = PolicyTy;
+	using layout_t = LayoutTy;
 	explicit atqueue(size_t __capacity):
-		capacity { __capacity },
-		_front { 0 },
-		_rear { 0 }
+		capacity { layout_t::round(__capacity) },
+		_rear { 0 },
+		_front { 0 }
 	{
-		_cont = new data_t[capacity];
-		_ptrs = new data_t*[capacity];
-		memset(_ptrs, 0, sizeof(data_t*) * capacity);
+		if (capacity == 0)
+			throw std::invalid_argument("atqueue capacity must be greater than zero");
+		_slots = new slot_t[capacity];
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			_slots[i].seq.store(i * 2, std::memory_order_relaxed);
+			_slots[i].alive = false;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
 	}
 	virtual ~atqueue()
 	{
-		if(_cont)
-			delete[] _cont;
-		if(_ptrs)
-			delete[] _ptrs;
+		if (!_slots)
+			return;
+		// Destroys the elements which are still in the ring
+		const uint64_t rear = _rear.load(std::memory_order_relaxed);
+		for (uint64_t pos = _front.load(std::memory_order_relaxed); pos != rear; ++pos)
+		{
+			if (_slots[_wrap(pos)].alive)
+				_slots[_wrap(pos)].data.destroy();
+		}
+		delete[] _slots;
 	}
 	template <typename DataRef>
 	bool enqueue(DataRef&& value, size_t retries = 0)
+	{
+		return _emplace(retries, std::forward<DataRef>(value));
+	}
+	// Constructs an element in the claimed slot from the arguments
+	template <class ...Args>
+	bool emplace(Args&& ...args)
+	{
+		return _emplace(0, std::forward<Args>(args)...);
+	}
+
+	bool dequeue(data_t& out)
+	{
+		return _dequeue([&out](data_t& elem) { out = static_cast<request_t>(elem); });
+	}
+	// Move-constructs the element into the caller's storage, which must be empty
+	bool try_dequeue(uninitialized<data_t>& out)
+	{
+		return _dequeue([&out](data_t& elem) { out.construct(static_cast<request_t>(elem)); });
+	}
+
+	/* Claims as many free slots as possible (up to std::distance(first, last)) with a single claim,
+	   then fills them in order. Returns the number of enqueued elements.
+	   If a constructor throws, the elements before it stay enqueued and the rest of the claimed slots are published dead. */
+	template <typename ForwardIt>
+	size_t enqueue_bulk(ForwardIt first, ForwardIt last)
+	{
+		const size_t request = static_cast<size_t>(std::distance(first, last));
+		if (request == 0)
+			return 0;
+		uint64_t rear = _rear.load(std::memory_order_relaxed);
+		size_t count = 0;
+
+		while (true)
+		{
+			count = _count_ready(rear, 0, request);
+			if (count == 0)
+			{
+				uint64_t seq = _slots[_wrap(rear)].seq.load(std::memory_order_acquire);
+				if (static_cast<int64_t>(seq) - static_cast<int64_t>(rear * 2) < 0)
+				{
+					count_full();
+					peak(capacity);
+					return 0; // Queue is full
+				}
+				count_cas_retry();
+				rear = _rear.load(std::memory_order_relaxed);
+				continue;
+			}
+			VEE_STRESS_POINT();
+			if (_claim(_rear, rear, count, mpl::binary_dispatch<policy_t::multi_producer>()))
+				break;
+			count_cas_retry();
+		}
+		size_t i = 0;
+		try
+		{
+			for (; i < count; ++i, ++first)
+			{
+				slot_t& slot = _slots[_wrap(rear + i)];
+				VEE_STRESS_POINT();
+				slot.data.construct(*first);
+				slot.alive = true;
+				slot.seq.store((rear + i) * 2 + 1, std::memory_order_release);
+			}
+		}
+		catch (...)
+		{
+			for (; i < count; ++i)
+				_publish_dead(rear + i);
+			throw;
+		}
+		sample([this]() { return guess_size(); });
+		return count;
+	}
+
+	/* Claims as many filled slots as possible (up to max) with a single claim,
+	   then drains them into out. Returns the number of dequeued elements, which skips the dead slots.
+	   If an assignment to out throws, the rest of the claimed elements are dropped along with the failed one. */
+	template <typename OutputIt>
+	size_t dequeue_bulk(OutputIt out, size_t max)
+	{
+		if (max == 0)
+			return 0;
+		uint64_t front = _front.load(std::memory_order_relaxed);
+		size_t count = 0;
+
+		while (true)
+		{
+			count = _count_ready(front, 1, max);
+			if (count == 0)
+			{
+				uint64_t seq = _slots[_wrap(front)].seq.load(std::memory_order_acquire);
+				if (static_cast<int64_t>(seq) - static_cast<int64_t>(front * 2 + 1) < 0)
+				{
+					count_empty();
+					return 0; // Queue is empty
+				}
+				count_cas_retry();
+				front = _front.load(std::memory_order_relaxed);
+				continue;
+			}
+			VEE_STRESS_POINT();
+			if (_claim(_front, front, count, mpl::binary_dispatch<policy_t::multi_consumer>()))
+				break;
+			count_cas_retry();
+		}
+		size_t done = 0;
+		size_t i = 0;
+		try
+		{
+			for (; i < count; ++i)
+			{
+				slot_t& slot = _slots[_wrap(front + i)];
+				VEE_STRESS_POINT();
+				if (slot.alive)
+				{
+					*out = static_cast<request_t>(*slot.data);
+					++out;
+					++done;
+				}
+				_release(front + i);
+			}
+		}
+		catch (...)
+		{
+			for (; i < count; ++i)
+				_release(front + i);
+			throw;
+		}
+		return done;
+	}
+
+	// The positions are read without synchronization, so the size may be stale when it returns
+	size_t guess_size() const
+	{
+		const uint64_t front = _front.load(std::memory_order_relaxed);
+		const uint64_t size = _rear.load(std::memory_order_relaxed) - front;
+		return (size < capacity) ? static_cast<size_t>(size) : capacity;
+	}
+	telemetry::snapshot collect_telemetry() const
+	{
+		return telemetry_t::collect(guess_size());
+	}
+	void reset_telemetry()
+	{
+		telemetry_t::reset();
+	}
+
+	const size_t capacity;
+private:
+	using telemetry_t = telemetry::recorder_t;
+	using request_t = std::conditional_t<
+		std::is_move_assignable<data_t>::value,
+		std::add_rvalue_reference_t<data_t>,
+		std::add_lvalue_reference_t<data_t> >;
+
+	struct slot_t
+	{
+		std::atomic<uint64_t> seq;
+		bool alive; // false if the constructor threw, written before seq is published
+		uninitialized<data_t> data;
+	};
+
+	// The claimed slot is always published, a throwing constructor leaves it dead
+	template <class ...Args>
+	bool _emplace(size_t retries, Args&& ...args)
 	{
 		size_t counter = 0;
+		uint64_t rear = _rear.load(std::memory_order_relaxed);
 
-		while (counter <= retries)
+		while (true)
 		{
-			std::atomic_thread_fence(std::memory_order_release);
-			size_t rear = _rear.load();
-			if (_ptrs[rear] == nullptr)
+			slot_t& slot = _slots[_wrap(rear)];
+			uint64_t seq = slot.seq.load(std::memory_order_acquire);
+			int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(rear * 2);
+			VEE_STRESS_POINT();
+			if (diff == 0)
 			{
-				size_t next = (rear + 1) % capacity;
-				if (std::atomic_compare_exchange_strong(&_rear, &rear, next))
+				if (_claim(_rear, rear, 1, mpl::binary_dispatch<policy_t::multi_producer>()))
 				{
-					_cont[rear] = std::forward<DataRef>(value);
-					_ptrs[rear] = &_cont[rear];
+					VEE_STRESS_POINT();
+					try
+					{
+						slot.data.construct(std::forward<Args>(args)...);
+					}
+					catch (...)
+					{
+						_publish_dead(rear);
+						throw;
+					}
+					slot.alive = true;
+					slot.seq.store(rear * 2 + 1, std::memory_order_release);
+					sample([this]() { return guess_size(); });
 					return true;
 				}
+				count_cas_retry();
 			}
-			else
+			else if (diff < 0)
 			{
 				// Queue is full
-				++counter;
+				if (counter++ >= retries)
+				{
+					count_full();
+					peak(capacity);
+					return false;
+				}
+				count_spin();
+				rear = _rear.load(std::memory_order_relaxed);
+			}
+			else
+			{
+				// Another producer has claimed the position
+				count_cas_retry();
+				rear = _rear.load(std::memory_order_relaxed);
 			}
 		}
-		return false;
 	}
-	
-	bool dequeue(data_t& out)
+
+	// Hands the claimed element over to the sink, then destroys it in the slot
+	template <class SinkFn>
+	bool _dequeue(SinkFn&& sink)
 	{
+		uint64_t front = _front.load(std::memory_order_relaxed);
+
 		while (true)
 		{
-			std::atomic_thread_fence(std::memory_order_acquire);
-			size_t front = _front.load();
-			if(_ptrs[front] != nullptr)
+			slot_t& slot = _slots[_wrap(front)];
+			uint64_t seq = slot.seq.load(std::memory_order_acquire);
+			int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(front * 2 + 1);
+			VEE_STRESS_POINT();
+			if (diff == 0)
 			{
-				size_t next = (front + 1) % capacity;
-				if(std::atomic_compare_exchange_strong(&_front, &front, next))
+				if (_claim(_front, front, 1, mpl::binary_dispatch<policy_t::multi_consumer>()))
 				{
-					using request_t = std::conditional_t<
-						std::is_move_assignable<data_t>::value,
-						std::add_rvalue_reference_t<data_t>,
-						std::add_lvalue_reference_t<data_t> >;
-					out = static_cast<request_t>(_cont[front]);
-					_ptrs[front] = nullptr;
+					VEE_STRESS_POINT();
+					if (!slot.alive)
+					{
+						// The constructor threw, the position is released and skipped
+						_release(front);
+						front = _front.load(std::memory_order_relaxed);
+						continue;
+					}
+					try
+					{
+						sink(*slot.data);
+					}
+					catch (...)
+					{
+						_release(front);
+						throw;
+					}
+					_release(front);
 					return true;
 				}
+				count_cas_retry();
 			}
-			else
+			else if (diff < 0)
 			{
 				// Queue is empty
-				break;
+				count_empty();
+				return false;
+			}
+			else
+			{
+				// Another consumer has claimed the position
+				count_cas_retry();
+				front = _front.load(std::memory_order_relaxed);
 			}
 		}
-		return false;
 	}
-	
-	const size_t capacity;
-private:
-	std::atomic<size_t> _front; // dequeue index
-	std::atomic<size_t> _rear;  // enqueue index
-	data_t* _cont = nullptr;
-	data_t** _ptrs = nullptr;
+
+	void _publish_dead(uint64_t pos)
+	{
+		slot_t& slot = _slots[_wrap(pos)];
+		slot.alive = false;
+		slot.seq.store(pos * 2 + 1, std::memory_order_release);
+	}
+
+	// Destroys the element of a claimed slot, if it has one, and frees the slot for the next lap
+	void _release(uint64_t pos)
+	{
+		slot_t& slot = _slots[_wrap(pos)];
+		if (slot.alive)
+			slot.data.destroy();
+		slot.seq.store((pos + capacity) * 2, std::memory_order_release);
+	}
+
+	inline size_t _wrap(uint64_t pos) const
+	{
+		return layout_t::wrap(pos, capacity);
+	}
+	inline static bool _claim(std::atomic<uint64_t>& pos, uint64_t& cur, size_t count, mpl::binary_dispatch<true>/*multi == true*/)
+	{
+		return pos.compare_exchange_weak(cur, cur + count, std::memory_order_relaxed);
+	}
+	inline static bool _claim(std::atomic<uint64_t>& pos, uint64_t& cur, size_t count, mpl::binary_dispatch<false>/*multi == false*/)
+	{
+		pos.store(cur + count, std::memory_order_relaxed);
+		return true;
+	}
+	// Counts the slots from the position pos whose sequence numbers are seq(pos), seq(pos + 1), ... (at most max)
+	inline size_t _count_ready(uint64_t pos, size_t seq_offset, size_t max) const
+	{
+		size_t count = 0;
+		while (count < max)
+		{
+			uint64_t seq = _slots[_wrap(pos + count)].seq.load(std::memory_order_acquire);
+			if (seq != (pos + count) * 2 + seq_offset)
+				break;
+			++count;
+		}
+		return count;
+	}
+
+	slot_t* _slots = nullptr;
+	char _pad0[VEE_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> _rear;  // enqueue position
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+	std::atomic<uint64_t> _front; // dequeue position
+	char _pad2[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
 
 	atqueue() = delete;
 	atqueue(const ref_t) = delete;
@@ -105,79 +406,303 @@ private:
 	ref_t operator=(rref_t) = delete;
 };
 
-template <typename DataTy>
-class queue final
+/* Single producer, single consumer ring (Lamport)
+   Each side owns its own position and keeps a cached copy of the remote one,
+   so the remote cache line is only read when the cached copy says full(empty).
+   A throw from the consumer's assignment drops the element and advances the front past it.
+   The positions are 64-bit for the same reason as in the MPMC ring. */
+template <typename DataTy, class LayoutTy>
+class atqueue<DataTy, property::spsc, LayoutTy>: private telemetry::recorder_t
 {
 public:
-	using this_t = atqueue<DataTy>;
+	using this_t = atqueue<DataTy, property::spsc, LayoutTy>;
 	using ref_t = this_t&;
 	using rref_t = this_t&&;
 	using data_t = DataTy;
-	queue(size_t __capacity):
-		capacity { __capacity },
-		_cont_queue { capacity },
-		_out_queue { capacity }
+	using policy_t = property::spsc;
+	using layout_t = LayoutTy;
+	explicit atqueue(size_t __capacity):
+		capacity { layout_t::round(__capacity) },
+		_rear { 0 },
+		_front_cache { 0 },
+		_front { 0 },
+		_rear_cache { 0 }
 	{
-		_cont = new data_t[capacity];
-		for (size_t i = 0; i < capacity; )
-		{
-			if (_cont_queue.enqueue(i))
-				++i;
-			else
-				throw std::runtime_error("queue initialization failed!");
-		}
+		if (capacity == 0)
+			throw std::invalid_argument("atqueue capacity must be greater than zero");
+		_cont = new uninitialized<data_t>[capacity];
 	}
-	~queue()
+	virtual ~atqueue()
 	{
+		if (!_cont)
+			return;
+		// Destroys the elements which are still in the ring
+		const uint64_t rear = _rear.load(std::memory_order_relaxed);
+		for (uint64_t pos = _front.load(std::memory_order_relaxed); pos != rear; ++pos)
+			_cont[_wrap(pos)].destroy();
 		delete[] _cont;
 	}
 	template <typename DataRef>
-	bool enqueue(DataRef&& data, size_t retries = 0)
+	bool enqueue(DataRef&& value, size_t retries = 0)
+	{
+		return _emplace(retries, std::forward<DataRef>(value));
+	}
+	template <class ...Args>
+	bool emplace(Args&& ...args)
+	{
+		return _emplace(0, std::forward<Args>(args)...);
+	}
+
+	bool dequeue(data_t& out)
+	{
+		return _dequeue([&out](data_t& elem) { out = static_cast<request_t>(elem); });
+	}
+	bool try_dequeue(uninitialized<data_t>& out)
+	{
+		return _dequeue([&out](data_t& elem) { out.construct(static_cast<request_t>(elem)); });
+	}
+
+	template <typename ForwardIt>
+	size_t enqueue_bulk(ForwardIt first, ForwardIt last)
+	{
+		const size_t request = static_cast<size_t>(std::distance(first, last));
+		const uint64_t rear = _rear.load(std::memory_order_relaxed);
+
+		if (capacity - (rear - _front_cache) < request)
+			_front_cache = _front.load(std::memory_order_acquire);
+		size_t count = static_cast<size_t>(capacity - (rear - _front_cache));
+		if (count > request)
+			count = request;
+		if (count == 0 && request != 0)
+		{
+			count_full();
+			peak(capacity);
+		}
+		size_t i = 0;
+		try
+		{
+			for (; i < count; ++i, ++first)
+				_cont[_wrap(rear + i)].construct(*first);
+		}
+		catch (...)
+		{
+			// Publishes the elements which were constructed before the throw
+			_rear.store(rear + i, std::memory_order_release);
+			throw;
+		}
+		VEE_STRESS_POINT();
+		_rear.store(rear + count, std::memory_order_release);
+		sample([this]() { return guess_size(); });
+		return count;
+	}
+
+	template <typename OutputIt>
+	size_t dequeue_bulk(OutputIt out, size_t max)
+	{
+		const uint64_t front = _front.load(std::memory_order_relaxed);
+
+		if (_rear_cache - front < max)
+			_rear_cache = _rear.load(std::memory_order_acquire);
+		size_t count = static_cast<size_t>(_rear_cache - front);
+		if (count > max)
+			count = max;
+		if (count == 0 && max != 0)
+			count_empty();
+		for (size_t i = 0; i < count; ++i, ++out)
+		{
+			uninitialized<data_t>& slot = _cont[_wrap(front + i)];
+			try
+			{
+				*out = static_cast<request_t>(*slot);
+			}
+			catch (...)
+			{
+				// The elements after the failed one stay in the ring
+				slot.destroy();
+				_front.store(front + i + 1, std::memory_order_release);
+				throw;
+			}
+			slot.destroy();
+		}
+		VEE_STRESS_POINT();
+		_front.store(front + count, std::memory_order_release);
+		return count;
+	}
+
+	// The positions are read without synchronization, so the size may be stale when it returns
+	size_t guess_size() const
+	{
+		const uint64_t front = _front.load(std::memory_order_relaxed);
+		const uint64_t size = _rear.load(std::memory_order_relaxed) - front;
+		return (size < capacity) ? static_cast<size_t>(size) : capacity;
+	}
+	telemetry::snapshot collect_telemetry() const
+	{
+		return telemetry_t::collect(guess_size());
+	}
+	void reset_telemetry()
+	{
+		telemetry_t::reset();
+	}
+
+	const size_t capacity;
+private:
+	using telemetry_t = telemetry::recorder_t;
+	using request_t = std::conditional_t<
+		std::is_move_assignable<data_t>::value,
+		std::add_rvalue_reference_t<data_t>,
+		std::add_lvalue_reference_t<data_t> >;
+
+	inline size_t _wrap(uint64_t pos) const
+	{
+		return layout_t::wrap(pos, capacity);
+	}
+
+	template <class ...Args>
+	bool _emplace(size_t retries, Args&& ...args)
 	{
 		size_t counter = 0;
+		const uint64_t rear = _rear.load(std::memory_order_relaxed);
 
-		while(counter <= retries)
+		while (rear - _front_cache == capacity)
 		{
-			size_t block_id = 0;
-			if (_cont_queue.dequeue(block_id))
+			_front_cache = _front.load(std::memory_order_acquire);
+			if (rear - _front_cache == capacity)
 			{
-				_cont[block_id] = std::forward<DataRef>(data);
-				while(!_out_queue.enqueue(block_id))
+				// Queue is full
+				if (counter++ >= retries)
 				{
-					
+					count_full();
+					peak(capacity);
+					return false;
 				}
-				return true;
-			}
-			else
-			{
-				++counter;
+				count_spin();
 			}
 		}
-		return false;
+		// Nothing is published before the construction, so a throw leaves the ring as it was
+		_cont[_wrap(rear)].construct(std::forward<Args>(args)...);
+		VEE_STRESS_POINT();
+		_rear.store(rear + 1, std::memory_order_release);
+		sample([this]() { return guess_size(); });
+		return true;
 	}
 
-	bool dequeue(data_t& out)
+	template <class SinkFn>
+	bool _dequeue(SinkFn&& sink)
 	{
-		size_t block_id = 0;
-		if (!_out_queue.dequeue(block_id))
-			return false;
-		using request_t = std::conditional_t<
-			std::is_move_assignable<data_t>::value,
-			std::add_rvalue_reference_t<data_t>,
-			std::add_lvalue_reference_t<data_t> >;
-		out = static_cast<request_t>(_cont[block_id]);
-		while (!_cont_queue.enqueue(block_id))
+		const uint64_t front = _front.load(std::memory_order_relaxed);
+
+		if (front == _rear_cache)
+		{
+			_rear_cache = _rear.load(std::memory_order_acquire);
+			if (front == _rear_cache)
+			{
+				count_empty();
+				return false; // Queue is empty
+			}
+		}
+		uninitialized<data_t>& slot = _cont[_wrap(front)];
+		try
+		{
+			sink(*slot);
+		}
+		catch (...)
 		{
-			
+			slot.destroy();
+			_front.store(front + 1, std::memory_order_release);
+			throw;
 		}
+		slot.destroy();
+		VEE_STRESS_POINT();
+		_front.store(front + 1, std::memory_order_release);
 		return true;
 	}
 
+	uninitialized<data_t>* _cont = nullptr;
+	char _pad0[VEE_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> _rear;  // enqueue position, written by the producer
+	uint64_t _front_cache;        // producer's copy of _front
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+	std::atomic<uint64_t> _front; // dequeue position, written by the consumer
+	uint64_t _rear_cache;         // consumer's copy of _rear
+	char _pad2[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+
+	atqueue() = delete;
+	atqueue(const ref_t) = delete;
+	atqueue(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+/* The payload is stored in the ring slot itself,
+   so an enqueue/dequeue pair costs one claim on each side of a single ring. */
+template <typename DataTy, class PolicyTy = property::mpmc, class LayoutTy = property::exact_capacity>
+class queue final
+{
+public:
+	using this_t = queue<DataTy, PolicyTy, LayoutTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	using policy_t = PolicyTy;
+	using layout_t = LayoutTy;
+	queue(size_t __capacity):
+		capacity { layout_t::round(__capacity) },
+		_ring { capacity }
+	{
+
+	}
+	~queue() = default;
+	template <typename DataRef>
+	bool enqueue(DataRef&& data, size_t retries = 0)
+	{
+		return _ring.enqueue(std::forward<DataRef>(data), retries);
+	}
+
+	template <class ...Args>
+	bool emplace(Args&& ...args)
+	{
+		return _ring.emplace(std::forward<Args>(args)...);
+	}
+
+	bool dequeue(data_t& out)
+	{
+		return _ring.dequeue(out);
+	}
+
+	bool try_dequeue(uninitialized<data_t>& out)
+	{
+		return _ring.try_dequeue(out);
+	}
+
+	template <typename ForwardIt>
+	size_t enqueue_bulk(ForwardIt first, ForwardIt last)
+	{
+		return _ring.enqueue_bulk(first, last);
+	}
+
+	template <typename OutputIt>
+	size_t dequeue_bulk(OutputIt out, size_t max)
+	{
+		return _ring.dequeue_bulk(out, max);
+	}
+
+	size_t guess_size() const
+	{
+		return _ring.guess_size();
+	}
+	telemetry::snapshot collect_telemetry() const
+	{
+		return _ring.collect_telemetry();
+	}
+	void reset_telemetry()
+	{
+		_ring.reset_telemetry();
+	}
+
 	const size_t capacity;
 private:
-	data_t* _cont;
-	atqueue<size_t> _cont_queue;
-	atqueue<size_t> _out_queue;
+	atqueue<data_t, policy_t, layout_t> _ring;
 
 	queue() = delete;
 	queue(const ref_t) = delete;
@@ -192,4 +717,4 @@ private:
 
 #pragma warning(default:4127)
 
-#endif // !_VEE_LOCKFREE_QUEUE_H_
\ No newline at end of file
+#endif // !_VEE_LOCKFREE_QUEUE_H_
@@ -1,8 +1,15 @@
 #ifndef _VEE_LOCKFREE_STACK_H_
 #define _VEE_LOCKFREE_STACK_H_
 
-#include <vee/lockfree/queue.h>
+#include <vee/platform.h>
+#include <vee/lockfree.h>
+#include <vee/lockfree/uninitialized.h>
+#include <vee/lockfree/stress.h>
+#include <vee/telemetry.h>
 #include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 
 #pragma warning(disable:4127)
 
@@ -10,99 +17,491 @@ namespace vee {
 
 namespace lockfree {
 
-template <typename DataTy>
-class stack final
+/* Intrusive Treiber stack of the indices [0, capacity)
+   The head packs the top index with a tag which is bumped by every successful CAS,
+   so a pop cannot succeed against a head which was popped and pushed again meanwhile (ABA).
+   Push and pop take a single CAS on the head, which makes the stack a cheap freelist for index-addressed pools;
+   push_chain and pop_chain move a whole chain of indices with a single CAS as well. */
+class index_stack final
 {
 public:
-	using this_t = stack<DataTy>;
+	using this_t = index_stack;
 	using ref_t = this_t&;
 	using rref_t = this_t&&;
-	using data_t = DataTy;
-	explicit stack(size_t __capacity):
+	using index_t = uint32_t;
+	static const index_t null_index = UINT32_MAX;
+
+	// The stack holds every index in ascending pop order if __filled is set, otherwise it is empty
+	explicit index_stack(size_t __capacity, bool __filled = false):
 		capacity { __capacity },
-		_cont_queue{ capacity },
-		_top { 0 }
+		_head { null_index }
+	{
+		if (capacity == 0 || capacity >= null_index)
+			throw std::invalid_argument("index_stack capacity is out of range");
+		_next = new std::atomic<index_t>[capacity];
+		for (size_t i = 0; i < capacity; ++i)
+			_next[i].store(null_index, std::memory_order_relaxed);
+		if (__filled)
+		{
+			for (size_t i = capacity; i > 0; --i)
+				push(static_cast<index_t>(i - 1));
+		}
+	}
+	~index_stack()
+	{
+		delete[] _next;
+	}
+	// The index must not be in the stack already
+	void push(index_t idx)
+	{
+		uint64_t head = _head.load(std::memory_order_relaxed);
+		do
+		{
+			_next[idx].store(_index(head), std::memory_order_relaxed);
+			VEE_STRESS_POINT();
+		} while (!_head.compare_exchange_weak(head, _pack(_tag(head) + 1, idx), std::memory_order_acq_rel, std::memory_order_relaxed));
+	}
+	// Gives up after a single CAS, fails if the head was contended
+	bool try_push(index_t idx)
+	{
+		uint64_t head = _head.load(std::memory_order_relaxed);
+		_next[idx].store(_index(head), std::memory_order_relaxed);
+		VEE_STRESS_POINT();
+		return _head.compare_exchange_strong(head, _pack(_tag(head) + 1, idx), std::memory_order_acq_rel, std::memory_order_relaxed);
+	}
+	// Links the indices in the given order and pushes them with a single CAS, so that ids[0] becomes the top
+	void push_chain(const index_t* ids, size_t count)
+	{
+		if (count == 0)
+			return;
+		for (size_t i = 0; i + 1 < count; ++i)
+			_next[ids[i]].store(ids[i + 1], std::memory_order_relaxed);
+		const index_t last = ids[count - 1];
+		uint64_t head = _head.load(std::memory_order_relaxed);
+		do
+		{
+			_next[last].store(_index(head), std::memory_order_relaxed);
+			VEE_STRESS_POINT();
+		} while (!_head.compare_exchange_weak(head, _pack(_tag(head) + 1, ids[0]), std::memory_order_acq_rel, std::memory_order_relaxed));
+	}
+	// Detaches up to max indices from the top with a single CAS, out[0] is the former top; returns the count
+	size_t pop_chain(index_t* out, size_t max)
+	{
+		if (max == 0)
+			return 0;
+		uint64_t head = _head.load(std::memory_order_acquire);
+		while (true)
+		{
+			index_t top = _index(head);
+			if (top == null_index)
+				return 0; // stack is empty
+			// The links in the stack do not change until one of the indices is popped, which bumps the tag
+			size_t count = 0;
+			index_t next = top;
+			while (count < max && next != null_index)
+			{
+				out[count++] = next;
+				next = _next[next].load(std::memory_order_relaxed);
+			}
+			VEE_STRESS_POINT();
+			if (_head.compare_exchange_weak(head, _pack(_tag(head) + 1, next), std::memory_order_acq_rel, std::memory_order_acquire))
+				return count;
+		}
+	}
+	bool pop(index_t& out)
 	{
-		_cont = new data_t[capacity];
-		_outarr = new data_t*[capacity];
-		memset(_outarr, 0, sizeof(data_t*) * capacity);
-		for (size_t i = 0; i < capacity; )
+		uint64_t head = _head.load(std::memory_order_acquire);
+		while (true)
 		{
-			if (_cont_queue.enqueue(i))
-				++i;
-			else
-				throw std::runtime_error("stack initialization failed!");
+			index_t top = _index(head);
+			if (top == null_index)
+				return false; // stack is empty
+			index_t next = _next[top].load(std::memory_order_relaxed);
+			VEE_STRESS_POINT(); // the window of the ABA problem
+			if (_head.compare_exchange_weak(head, _pack(_tag(head) + 1, next), std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				out = top;
+				return true;
+			}
 		}
 	}
+	// Gives up after a single CAS, fails if the stack is empty or the head was contended
+	bool try_pop(index_t& out)
+	{
+		uint64_t head = _head.load(std::memory_order_acquire);
+		index_t top = _index(head);
+		if (top == null_index)
+			return false; // stack is empty
+		index_t next = _next[top].load(std::memory_order_relaxed);
+		VEE_STRESS_POINT();
+		if (!_head.compare_exchange_strong(head, _pack(_tag(head) + 1, next), std::memory_order_acq_rel, std::memory_order_relaxed))
+			return false;
+		out = top;
+		return true;
+	}
+	bool empty() const
+	{
+		return _index(_head.load(std::memory_order_relaxed)) == null_index;
+	}
+
+	const size_t capacity;
+private:
+	static uint64_t _pack(uint64_t tag, index_t idx)
+	{
+		return (tag << 32) | idx;
+	}
+	static uint64_t _tag(uint64_t head)
+	{
+		return head >> 32;
+	}
+	static index_t _index(uint64_t head)
+	{
+		return static_cast<index_t>(head & UINT32_MAX);
+	}
+
+	std::atomic<index_t>* _next = nullptr;
+	std::atomic<uint64_t> _head;
+	char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)]; // keeps the heads of adjacent stacks apart
+
+	index_stack(const ref_t) = delete;
+	index_stack(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+/* Bounded LIFO stack on an array of blocks
+   The blocks are moved between two index stacks, one of the free blocks and one of the stacked blocks,
+   so a push or a pop takes two CASes, one on each list, and never waits for another thread.
+   A freelist of indices should use index_stack directly, which takes a single CAS per operation.
+
+   With a single producer(spsc, spmc) only the pusher takes free blocks, so it detaches up to spare_blocks
+   of them with a single CAS(index_stack::pop_chain) and keeps them privately; most pushes then take
+   only the CAS on the stacked blocks. The stack is full when the spare blocks and the free list are both empty.
+   A single consumer has no cheaper path: the pushers race on the head of the stacked blocks either way,
+   and the popped block has to go back to the free list at once for the pushers to see it.
+
+   With EliminationSlots > 0 a push or pop which loses the CAS on the head of the stacked blocks visits
+   a random slot of an elimination array instead of retrying at once (Hendler, Shavit and Yerushalmi).
+   A pusher offers the index of its block, which already holds the element, and a popper which meets it
+   takes the block with a single CAS on the slot, so the colliding pair completes without touching the head.
+   Neither side waits for the other: the pusher withdraws its offer after a bounded spin, and once a popper
+   has taken the block there is nothing left for the pusher to do.
+   The range of the visited slots grows on collisions inside the array and shrinks when nobody shows up.
+   The blocks are raw storage, an element lives only between its push and its pop.
+   If the assignment(or the construction) into the popper's storage throws, the element is destroyed and
+   its block goes back to the free list before the exception leaves.
+   The contention counters(vee/telemetry.h) are compiled in with VEE_TELEMETRY; the positions tell nothing
+   about the size of a stack, so the telemetry also keeps the occupancy and guess_size needs it. */
+template <typename DataTy, class PolicyTy = property::mpmc, size_t EliminationSlots = 0>
+class stack final: private telemetry::recorder_t
+{
+public:
+	using this_t = stack<DataTy, PolicyTy, EliminationSlots>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	using policy_t = PolicyTy;
+	static const size_t elimination_slots = EliminationSlots;
+	// Free blocks which a single producer detaches at once
+	static const size_t spare_blocks = 64;
+	// Iterations which a thread waits in an elimination slot for its partner
+	static const size_t elimination_spins = 64;
+	explicit stack(size_t __capacity):
+		capacity { __capacity },
+		_free { __capacity, true },
+		_used { __capacity },
+		_width { 1 }
+	{
+		_cont = new uninitialized<data_t>[capacity];
+		for (auto& it : _slots)
+			it.offer.store(index_stack::null_index, std::memory_order_relaxed);
+	}
 	~stack()
 	{
-		if (_cont)
-			delete[] _cont;
-		if (_outarr)
-			delete[] _outarr;
+		if (!_cont)
+			return;
+		index_stack::index_t block_id = 0;
+		while (_used.pop(block_id))
+			_cont[block_id].destroy();
+		delete[] _cont;
 	}
 	template <typename DataRef>
 	bool push(DataRef&& data)
 	{
-		std::atomic_thread_fence(std::memory_order_release);
-		size_t block_id = 0;
-		if (_cont_queue.dequeue(block_id))
+		index_stack::index_t block_id = 0;
+		if (!_acquire(block_id))
+			return false; // stack is full
+		VEE_STRESS_POINT();
+		_construct(block_id, std::forward<DataRef>(data));
+		_publish(block_id);
+		_record_push();
+		return true;
+	}
+	// Constructs an element in a free block from the arguments
+	template <class ...Args>
+	bool emplace(Args&& ...args)
+	{
+		index_stack::index_t block_id = 0;
+		if (!_acquire(block_id))
+			return false; // stack is full
+		_construct(block_id, std::forward<Args>(args)...);
+		_publish(block_id);
+		_record_push();
+		return true;
+	}
+	bool pop(data_t& out)
+	{
+		return _pop([&out](data_t& elem) { out = static_cast<request_t>(elem); });
+	}
+	// Move-constructs the element into the caller's storage, which must be empty
+	bool try_pop(uninitialized<data_t>& out)
+	{
+		return _pop([&out](data_t& elem) { out.construct(static_cast<request_t>(elem)); });
+	}
+
+	template <bool Enabled = (VEE_TELEMETRY != 0)>
+	size_t guess_size() const
+	{
+		static_assert(Enabled, "stack::guess_size needs VEE_TELEMETRY");
+		return telemetry_t::occupancy();
+	}
+	telemetry::snapshot collect_telemetry() const
+	{
+		return telemetry_t::collect(telemetry_t::occupancy());
+	}
+	void reset_telemetry()
+	{
+		telemetry_t::reset();
+	}
+
+	const size_t capacity;
+private:
+	using telemetry_t = telemetry::recorder_t;
+	using request_t = std::conditional_t<
+		std::is_move_assignable<data_t>::value,
+		std::add_rvalue_reference_t<data_t>,
+		std::add_lvalue_reference_t<data_t> >;
+
+	// The offered block index packed with a tag bumped by every offer and take, an empty slot holds null_index
+	struct slot_t
+	{
+		std::atomic<uint64_t> offer;
+		char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+	};
+
+	// Takes a free block, from the spare blocks of a single producer if there are any
+	bool _acquire(index_stack::index_t& block_id)
+	{
+		if (!policy_t::multi_producer)
 		{
-			_cont[block_id] = std::forward<DataRef>(data);
-			size_t outidx = _top.fetch_add(1);
-			while (_outarr[outidx] != nullptr)
+			if (_spare_count == 0)
+				_spare_count = _free.pop_chain(_spare, spare_blocks);
+			if (_spare_count == 0)
 			{
-				
+				count_full();
+				return false;
 			}
-			_outarr[outidx] = &_cont[block_id];
+			block_id = _spare[--_spare_count];
+			return true;
 		}
-		else
+		while (!_free.try_pop(block_id))
 		{
-			return false; // stack is full
+			if (_free.empty())
+			{
+				count_full();
+				return false;
+			}
+			count_cas_retry();
 		}
 		return true;
 	}
-	bool pop(data_t& out)
+
+	// Returns the block to the free list if the constructor throws
+	template <class ...Args>
+	void _construct(index_stack::index_t block_id, Args&& ...args)
 	{
-		while (true)
+		try
+		{
+			_cont[block_id].construct(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			_free.push(block_id);
+			throw;
+		}
+	}
+
+	// Hands the popped element over to the sink, then destroys it
+	template <class SinkFn>
+	bool _pop(SinkFn&& sink)
+	{
+		index_stack::index_t block_id = 0;
+		while (!_used.try_pop(block_id))
 		{
-			std::atomic_thread_fence(std::memory_order_acquire);
-			size_t top = _top.load();
-			size_t dst = (top - 1);
-			if (top == 0)
+			if (_used.empty())
+			{
+				count_empty();
 				return false; // stack is empty
-			if (_outarr[dst] != nullptr)
+			}
+			count_cas_retry();
+			if (elimination_slots && _eliminate_pop(block_id))
+				break;
+		}
+		VEE_STRESS_POINT();
+		try
+		{
+			sink(*_cont[block_id]);
+		}
+		catch (...)
+		{
+			_release(block_id);
+			throw;
+		}
+		_release(block_id);
+		return true;
+	}
+
+	void _release(index_stack::index_t block_id)
+	{
+		_cont[block_id].destroy();
+		_free.push(block_id);
+		count_removed();
+	}
+
+	// Pushes the constructed block to the stacked blocks, or hands it over to a popper in an elimination slot
+	void _publish(index_stack::index_t block_id)
+	{
+		if (!elimination_slots)
+		{
+			_used.push(block_id);
+			return;
+		}
+		while (!_used.try_push(block_id))
+		{
+			count_cas_retry();
+			if (_eliminate_push(block_id))
+				return;
+		}
+	}
+
+	void _record_push()
+	{
+		count_added();
+		sample([this]() { return telemetry_t::occupancy(); });
+	}
+
+	static size_t _random()
+	{
+		static thread_local uint32_t seed = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&seed)) | 1;
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	slot_t& _visit()
+	{
+		return _slots[_random() % _width.load(std::memory_order_relaxed)];
+	}
+
+	void _resize(bool grow)
+	{
+		size_t width = _width.load(std::memory_order_relaxed);
+		if (grow && width < elimination_slots)
+			_width.compare_exchange_weak(width, width + 1, std::memory_order_relaxed);
+		else if (!grow && width > 1)
+			_width.compare_exchange_weak(width, width - 1, std::memory_order_relaxed);
+	}
+
+	static uint64_t _pack(uint64_t tag, index_stack::index_t idx)
+	{
+		return (tag << 32) | idx;
+	}
+	static uint64_t _tag(uint64_t offer)
+	{
+		return offer >> 32;
+	}
+	static index_stack::index_t _index(uint64_t offer)
+	{
+		return static_cast<index_stack::index_t>(offer & UINT32_MAX);
+	}
+
+	// Offers the block in a slot, and returns true if a popper has taken it
+	bool _eliminate_push(index_stack::index_t block_id)
+	{
+		slot_t& slot = _visit();
+		uint64_t offer = slot.offer.load(std::memory_order_relaxed);
+		if (_index(offer) != index_stack::null_index)
+		{
+			_resize(true); // another pusher is in the slot
+			return false;
+		}
+		// The tag tells this offer apart from a later offer of the same block, once it has been taken and freed
+		const uint64_t mine = _pack(_tag(offer) + 1, block_id);
+		if (!slot.offer.compare_exchange_strong(offer, mine, std::memory_order_release, std::memory_order_relaxed))
+		{
+			_resize(true);
+			return false;
+		}
+		VEE_STRESS_POINT();
+		size_t spins = 0;
+		for (; spins < elimination_spins; ++spins)
+		{
+			if (slot.offer.load(std::memory_order_relaxed) != mine)
+				break;
+		}
+		count_spin(spins);
+		offer = mine;
+		if (slot.offer.compare_exchange_strong(offer, _pack(_tag(mine) + 1, index_stack::null_index), std::memory_order_relaxed))
+		{
+			_resize(false); // withdrawn, nobody came
+			return false;
+		}
+		return true; // a popper owns the block now
+	}
+
+	// Waits for an offer in a slot, and returns true if a pushed block was taken
+	bool _eliminate_pop(index_stack::index_t& block_id)
+	{
+		slot_t& slot = _visit();
+		for (size_t i = 0; i < elimination_spins; ++i)
+		{
+			uint64_t offer = slot.offer.load(std::memory_order_relaxed);
+			if (_index(offer) != index_stack::null_index)
 			{
-				if (std::atomic_compare_exchange_strong(&_top, &top, dst))
+				count_spin(i);
+				if (slot.offer.compare_exchange_strong(offer, _pack(_tag(offer) + 1, index_stack::null_index), std::memory_order_acquire, std::memory_order_relaxed))
 				{
-					using request_t = std::conditional_t<
-						std::is_move_assignable<data_t>::value,
-						std::add_rvalue_reference_t<data_t>,
-						std::add_lvalue_reference_t<data_t> >;
-					out = static_cast<request_t>(_cont[dst]);
-					_outarr[dst] = nullptr;
-                    while (!_cont_queue.enqueue(dst))
-                    {
-
-                    }
+					block_id = _index(offer);
 					return true;
 				}
+				_resize(true); // another popper took the offer
+				return false;
 			}
 		}
+		count_spin(elimination_spins);
+		_resize(false);
+		return false;
 	}
 
-	const size_t capacity;
-private:
-	data_t* _cont = nullptr;
-	data_t** _outarr = nullptr;
-	atqueue<size_t> _cont_queue;
-	std::atomic<size_t> _top;
+	uninitialized<data_t>* _cont = nullptr;
+	index_stack _free;
+	index_stack _used;
+	std::atomic<size_t> _width;
+	slot_t _slots[EliminationSlots ? EliminationSlots : 1];
+	index_stack::index_t _spare[policy_t::multi_producer ? 1 : spare_blocks]; // owned by the single producer
+	size_t _spare_count = 0;
+
+	stack(const ref_t) = delete;
+	stack(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
 };
 
 } // !namespace lockfree
-	
+
 } // !namespace vee
 
 #pragma warning(default:4127)
 
-#endif // !_VEE_LOCKFREE_STATCK_H_
\ No newline at end of file
+#endif // !_VEE_LOCKFREE_STACK_H_
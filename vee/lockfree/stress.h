@@ -0,0 +1,77 @@
+#ifndef _VEE_LOCKFREE_STRESS_H_
+#define _VEE_LOCKFREE_STRESS_H_
+
+#include <vee/platform.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/* Delay injection for the stress tests of the lockfree containers
+   The containers mark the windows between their atomic steps(between reading a head and the CAS on it,
+   between claiming a slot and publishing it, ...) with VEE_STRESS_POINT(). The points compile to nothing
+   unless VEE_LOCKFREE_STRESS is set to 1; then every point delays the calling thread at random,
+   so that the interleavings which are rare under real load show up within seconds.
+   The header-only containers must be compiled with the same setting in the whole program. */
+#if VEE_LOCKFREE_STRESS
+#define VEE_STRESS_POINT() ::vee::lockfree::stress::point()
+#else
+#define VEE_STRESS_POINT() ((void)0)
+#endif
+
+namespace vee {
+
+namespace lockfree {
+
+namespace stress {
+
+// Changes the seed of the threads which make their first point after the call
+inline std::atomic<uint32_t>& global_seed()
+{
+	static std::atomic<uint32_t> seed { 0x9E3779B9 };
+	return seed;
+}
+
+inline uint32_t random()
+{
+	static thread_local uint32_t state = 0;
+	if (state == 0)
+	{
+		static std::atomic<uint32_t> threads { 0 };
+		state = (global_seed().load(std::memory_order_relaxed) ^ (threads.fetch_add(1, std::memory_order_relaxed) * 0x85EBCA6B)) | 1;
+	}
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// Mostly passes, sometimes spins, yields the core or sleeps for a moment
+inline void point()
+{
+	const uint32_t r = random();
+	switch (r & 15)
+	{
+	case 0:
+	case 1:
+		std::this_thread::yield();
+		break;
+	case 2:
+		for (volatile uint32_t i = 0; i < ((r >> 4) & 1023); ++i);
+		break;
+	case 3:
+		if (((r >> 4) & 63) == 0)
+			std::this_thread::sleep_for(std::chrono::microseconds((r >> 10) & 127));
+		break;
+	default:
+		break;
+	}
+}
+
+} // !namespace stress
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_STRESS_H_
@@ -0,0 +1,333 @@
+#ifndef _VEE_LOCKFREE_UNBOUNDED_QUEUE_H_
+#define _VEE_LOCKFREE_UNBOUNDED_QUEUE_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree/ebr.h>
+#include <vee/lockfree/hazard_pointer.h>
+#include <vee/lockfree/uninitialized.h>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <thread>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lockfree {
+
+/* Unbounded MPMC queue made of linked fixed-size segments (FAA array queue)
+   Producers and consumers claim a cell of the tail(head) segment with a fetch_add, and a consumer which
+   overtakes a late producer marks the cell as taken so that the producer retries with another cell.
+   The element is constructed in the claimed cell; if the constructor throws, the producer marks the cell as taken
+   itself, and the consumer of the cell moves on to another one.
+   A throw from the consumer's assignment drops the element, the cell is left taken.
+   An exhausted segment is unlinked from the head, retired to the reclamation scheme(ebr or hazard_pointer),
+   and recycled through the freelist once no thread can reach it,
+   so the queue allocates only while it grows beyond its peak size. */
+template <typename DataTy, size_t SegmentSize = 256, class ReclaimerTy = ebr>
+class unbounded_queue final
+{
+public:
+	using this_t = unbounded_queue<DataTy, SegmentSize, ReclaimerTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	using reclaimer_t = ReclaimerTy;
+	static const size_t segment_size = SegmentSize;
+	static_assert(SegmentSize > 0, "segment size must be greater than zero");
+
+	explicit unbounded_queue(size_t __reserved_segments = 1):
+		_head { nullptr },
+		_tail { nullptr },
+		_pool { new pool_t }
+	{
+		segment_t* first = _new_segment();
+		_head.store(first, std::memory_order_relaxed);
+		_tail.store(first, std::memory_order_relaxed);
+		for (size_t i = 1; i < __reserved_segments; ++i)
+			_push(_pool->freelist, _new_segment());
+	}
+	~unbounded_queue()
+	{
+		segment_t* seg = _head.load(std::memory_order_relaxed);
+		while (seg)
+		{
+			segment_t* victim = seg;
+			seg = seg->next.load(std::memory_order_relaxed);
+			for (auto& it : victim->cells)
+			{
+				if (it.state.load(std::memory_order_relaxed) == cell_full)
+					it.data.destroy();
+			}
+			delete victim;
+		}
+		// The retired segments keep the pool alive until they are reclaimed
+		_release(_pool);
+	}
+	// Never fails, the return value is kept for the interface compatibility with the bounded queues
+	template <typename DataRef>
+	bool enqueue(DataRef&& value)
+	{
+		return emplace(std::forward<DataRef>(value));
+	}
+	// Constructs an element in the claimed cell from the arguments
+	template <class ...Args>
+	bool emplace(Args&& ...args)
+	{
+		typename reclaimer_t::guard guard;
+
+		while (true)
+		{
+			segment_t* tail = guard.protect(_tail);
+			size_t idx = tail->enqidx.fetch_add(1, std::memory_order_relaxed);
+			if (idx < segment_size)
+			{
+				cell_t& cell = tail->cells[idx];
+				uint32_t state = cell_empty;
+				if (cell.state.compare_exchange_strong(state, cell_writing, std::memory_order_acquire))
+				{
+					try
+					{
+						cell.data.construct(std::forward<Args>(args)...);
+					}
+					catch (...)
+					{
+						cell.state.store(cell_taken, std::memory_order_release);
+						throw;
+					}
+					cell.state.store(cell_full, std::memory_order_release);
+					return true;
+				}
+				// A consumer has taken the cell, retry with another cell
+				continue;
+			}
+			// The tail segment is exhausted, link(or help to link) the next segment
+			segment_t* next = tail->next.load(std::memory_order_acquire);
+			if (next == nullptr)
+			{
+				segment_t* fresh = _acquire_segment(guard);
+				if (tail->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel))
+					next = fresh;
+				else
+					_retire(fresh); // never published, but a racing pop may still hold it as the freelist head
+			}
+			_tail.compare_exchange_strong(tail, next, std::memory_order_acq_rel);
+		}
+	}
+
+	bool dequeue(data_t& out)
+	{
+		return _dequeue([&out](data_t& elem) { out = static_cast<request_t>(elem); });
+	}
+	// Move-constructs the element into the caller's storage, which must be empty
+	bool try_dequeue(uninitialized<data_t>& out)
+	{
+		return _dequeue([&out](data_t& elem) { out.construct(static_cast<request_t>(elem)); });
+	}
+
+	// The number of segments which were allocated from the heap so far
+	size_t guess_allocated_segments() const
+	{
+		return _pool->allocated.load(std::memory_order_relaxed);
+	}
+
+private:
+	using request_t = std::conditional_t<
+		std::is_move_assignable<data_t>::value,
+		std::add_rvalue_reference_t<data_t>,
+		std::add_lvalue_reference_t<data_t> >;
+
+	enum : uint32_t
+	{
+		cell_empty = 0,
+		cell_writing,
+		cell_full,
+		cell_taken
+	};
+
+	// Hands the claimed element over to the sink, then destroys it in the cell
+	template <class SinkFn>
+	bool _dequeue(SinkFn&& sink)
+	{
+		typename reclaimer_t::guard guard;
+
+		while (true)
+		{
+			segment_t* head = guard.protect(_head);
+			size_t deqidx = head->deqidx.load(std::memory_order_relaxed);
+			if ((deqidx >= segment_size || deqidx >= head->enqidx.load(std::memory_order_relaxed))
+				&& head->next.load(std::memory_order_acquire) == nullptr)
+				return false; // Queue is empty
+			size_t idx = head->deqidx.fetch_add(1, std::memory_order_relaxed);
+			if (idx >= segment_size)
+			{
+				segment_t* next = head->next.load(std::memory_order_acquire);
+				if (next == nullptr)
+					return false; // Queue is empty
+				// The tail must leave the segment before it is unlinked
+				segment_t* tail = head;
+				_tail.compare_exchange_strong(tail, next, std::memory_order_acq_rel);
+				if (_head.compare_exchange_strong(head, next, std::memory_order_acq_rel))
+					_retire(head);
+				continue;
+			}
+			cell_t& cell = head->cells[idx];
+			uint32_t state = cell_empty;
+			if (cell.state.compare_exchange_strong(state, cell_taken, std::memory_order_acquire))
+				continue; // The producer is late, it will retry with another cell
+			while (state == cell_writing)
+			{
+				std::this_thread::yield();
+				state = cell.state.load(std::memory_order_acquire);
+			}
+			if (state == cell_taken)
+				continue; // The constructor threw in the producer
+			try
+			{
+				sink(*cell.data);
+			}
+			catch (...)
+			{
+				cell.data.destroy();
+				cell.state.store(cell_taken, std::memory_order_relaxed);
+				throw;
+			}
+			cell.data.destroy();
+			cell.state.store(cell_taken, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// Guard slot of the freelist head, the segments use the slot 0
+	static const size_t freelist_slot = 1;
+
+	struct cell_t
+	{
+		std::atomic<uint32_t> state;
+		uninitialized<data_t> data; // alive while the state is cell_full
+	};
+
+	struct pool_t;
+
+	struct segment_t
+	{
+		std::atomic<size_t> deqidx;
+		char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> enqidx;
+		char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+		std::atomic<segment_t*> next;
+		std::atomic<segment_t*> free_next; // a losing pop may read it while the winner resets the segment
+		pool_t* pool;
+		cell_t cells[SegmentSize];
+
+		void reset()
+		{
+			deqidx.store(0, std::memory_order_relaxed);
+			enqidx.store(0, std::memory_order_relaxed);
+			next.store(nullptr, std::memory_order_relaxed);
+			free_next.store(nullptr, std::memory_order_relaxed);
+			for (auto& it : cells)
+				it.state.store(cell_empty, std::memory_order_relaxed);
+		}
+	};
+
+	// Shared by the queue and its retired segments, deleted by whoever drops the last reference
+	struct pool_t
+	{
+		std::atomic<segment_t*> freelist { nullptr };
+		std::atomic<size_t> refs { 1 };
+		std::atomic<size_t> allocated { 0 };
+	};
+
+	segment_t* _new_segment()
+	{
+		segment_t* seg = new segment_t;
+		seg->reset();
+		seg->pool = _pool;
+		_pool->allocated.fetch_add(1, std::memory_order_relaxed);
+		return seg;
+	}
+
+	// Treiber push, the freelist head is protected by the popping thread and every segment is retired
+	// before it comes back to the freelist, so the head cannot be recycled while a pop is in flight
+	static void _push(std::atomic<segment_t*>& list, segment_t* seg)
+	{
+		segment_t* head = list.load(std::memory_order_relaxed);
+		do
+		{
+			seg->free_next.store(head, std::memory_order_relaxed);
+		} while (!list.compare_exchange_weak(head, seg, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	static segment_t* _pop(std::atomic<segment_t*>& list, typename reclaimer_t::guard& guard)
+	{
+		while (true)
+		{
+			segment_t* head = guard.protect(list, freelist_slot);
+			if (head == nullptr || list.compare_exchange_strong(head, head->free_next.load(std::memory_order_relaxed), std::memory_order_acquire))
+				return head;
+		}
+	}
+
+	segment_t* _acquire_segment(typename reclaimer_t::guard& guard)
+	{
+		segment_t* seg = _pop(_pool->freelist, guard);
+		if (seg == nullptr)
+		{
+			reclaimer_t::flush();
+			seg = _pop(_pool->freelist, guard);
+		}
+		if (seg == nullptr)
+			return _new_segment();
+		seg->reset();
+		return seg;
+	}
+
+	void _retire(segment_t* seg)
+	{
+		_pool->refs.fetch_add(1, std::memory_order_relaxed);
+		reclaimer_t::retire(seg, &_recycle);
+	}
+
+	static void _recycle(void* ptr)
+	{
+		segment_t* seg = static_cast<segment_t*>(ptr);
+		pool_t* pool = seg->pool;
+		_push(pool->freelist, seg);
+		_release(pool);
+	}
+
+	static void _release(pool_t* pool)
+	{
+		if (pool->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		segment_t* seg = pool->freelist.load(std::memory_order_relaxed);
+		while (seg)
+		{
+			segment_t* victim = seg;
+			seg = seg->free_next.load(std::memory_order_relaxed);
+			delete victim;
+		}
+		delete pool;
+	}
+
+	std::atomic<segment_t*> _head;
+	char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<segment_t*>)];
+	std::atomic<segment_t*> _tail;
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<segment_t*>)];
+	pool_t* _pool;
+
+	unbounded_queue(const ref_t) = delete;
+	unbounded_queue(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCKFREE_UNBOUNDED_QUEUE_H_
@@ -0,0 +1,56 @@
+#ifndef _VEE_LOCKFREE_UNINITIALIZED_H_
+#define _VEE_LOCKFREE_UNINITIALIZED_H_
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace vee {
+
+namespace lockfree {
+
+/* Raw storage for one object which is constructed and destroyed explicitly
+   The containers keep their slots in this, so a slot holds an object only while it is filled:
+   an empty ring neither default-constructs its elements nor keeps the moved-from ones alive. */
+template <typename DataTy>
+class uninitialized
+{
+public:
+	using this_t = uninitialized<DataTy>;
+	using data_t = DataTy;
+	uninitialized() = default;
+	~uninitialized() = default;
+	template <class ...Args>
+	void construct(Args&& ...args)
+	{
+		::new (static_cast<void*>(&_raw)) data_t(std::forward<Args>(args)...);
+	}
+	void destroy()
+	{
+		get().~data_t();
+	}
+	data_t& get()
+	{
+		return *reinterpret_cast<data_t*>(&_raw);
+	}
+	data_t& operator*()
+	{
+		return get();
+	}
+	data_t* operator->()
+	{
+		return &get();
+	}
+
+private:
+	typename std::aligned_storage<sizeof(data_t), std::alignment_of<data_t>::value>::type _raw;
+
+	uninitialized(const this_t&) = delete;
+	this_t& operator=(const this_t&) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#endif // !_VEE_LOCKFREE_UNINITIALIZED_H_
@@ -0,0 +1,170 @@
+#ifndef _VEE_LOCKFREE_WORK_STEALING_DEQUE_H_
+#define _VEE_LOCKFREE_WORK_STEALING_DEQUE_H_
+
+#include <vee/platform.h>
+#include <vee/lockfree/ebr.h>
+#include <vee/lockfree/hazard_pointer.h>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#pragma warning(disable:4127)
+
+namespace vee {
+
+namespace lockfree {
+
+/* Dynamically resizable work-stealing deque (Chase and Lev, with the C11 memory orderings of Le et al.)
+   The owner thread pushes and pops at the bottom without a CAS except when it races for the last element,
+   and any other thread steals from the top with a single CAS.
+   The circular buffer doubles when it is full; the old buffer is retired to the reclamation scheme
+   because a thief may still be reading it.
+   A thief reads an element before it knows whether its CAS wins, so the elements are kept in atomics
+   and must be trivially copyable (e.g. job pointers or indices). */
+template <typename DataTy, class ReclaimerTy = ebr>
+class work_stealing_deque final
+{
+public:
+	using this_t = work_stealing_deque<DataTy, ReclaimerTy>;
+	using ref_t = this_t&;
+	using rref_t = this_t&&;
+	using data_t = DataTy;
+	using reclaimer_t = ReclaimerTy;
+	static_assert(std::is_trivially_copyable<data_t>::value, "data type of work_stealing_deque must be trivially copyable");
+
+	// The initial capacity is rounded up to a power of two
+	explicit work_stealing_deque(size_t __initial_capacity = 64):
+		_top { 0 },
+		_bottom { 0 },
+		_buffer { nullptr }
+	{
+		size_t capacity = 1;
+		while (capacity < __initial_capacity)
+			capacity <<= 1;
+		_buffer.store(_new_buffer(capacity), std::memory_order_relaxed);
+	}
+	~work_stealing_deque()
+	{
+		_delete_buffer(_buffer.load(std::memory_order_relaxed));
+	}
+	// Owner only
+	void push(data_t value)
+	{
+		int64_t bottom = _bottom.load(std::memory_order_relaxed);
+		int64_t top = _top.load(std::memory_order_acquire);
+		buffer_t* buffer = _buffer.load(std::memory_order_relaxed);
+		if (bottom - top > static_cast<int64_t>(buffer->mask))
+			buffer = _grow(buffer, top, bottom);
+		buffer->at(bottom).store(value, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	// Owner only, takes the most recently pushed element
+	bool pop(data_t& out)
+	{
+		int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+		buffer_t* buffer = _buffer.load(std::memory_order_relaxed);
+		_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = _top.load(std::memory_order_relaxed);
+		if (top > bottom)
+		{
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false; // deque is empty
+		}
+		data_t value = buffer->at(bottom).load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// The last element, race against the thieves
+			bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			if (!won)
+				return false; // a thief took it
+		}
+		out = value;
+		return true;
+	}
+	// Any thread, takes the least recently pushed element
+	// Fails if the deque is empty or another thread won the element
+	bool steal(data_t& out)
+	{
+		int64_t top = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = _bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return false; // deque is empty
+		typename reclaimer_t::guard guard;
+		buffer_t* buffer = guard.protect(_buffer);
+		data_t value = buffer->at(top).load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false; // lost the race
+		out = value;
+		return true;
+	}
+	size_t guess_size() const
+	{
+		int64_t size = _bottom.load(std::memory_order_relaxed) - _top.load(std::memory_order_relaxed);
+		return (size > 0) ? static_cast<size_t>(size) : 0;
+	}
+	size_t guess_capacity() const
+	{
+		return _buffer.load(std::memory_order_relaxed)->mask + 1;
+	}
+
+private:
+	struct buffer_t
+	{
+		size_t mask;
+		std::atomic<data_t>* cells;
+
+		std::atomic<data_t>& at(int64_t idx)
+		{
+			return cells[static_cast<size_t>(idx) & mask];
+		}
+	};
+
+	static buffer_t* _new_buffer(size_t capacity)
+	{
+		buffer_t* buffer = new buffer_t;
+		buffer->mask = capacity - 1;
+		buffer->cells = new std::atomic<data_t>[capacity];
+		return buffer;
+	}
+
+	static void _delete_buffer(void* ptr)
+	{
+		buffer_t* buffer = static_cast<buffer_t*>(ptr);
+		delete[] buffer->cells;
+		delete buffer;
+	}
+
+	// Copies the live range into a buffer twice as large, the thieves may still read the old one
+	buffer_t* _grow(buffer_t* old, int64_t top, int64_t bottom)
+	{
+		buffer_t* buffer = _new_buffer((old->mask + 1) * 2);
+		for (int64_t i = top; i < bottom; ++i)
+			buffer->at(i).store(old->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_buffer.store(buffer, std::memory_order_release);
+		reclaimer_t::retire(old, &_delete_buffer);
+		return buffer;
+	}
+
+	std::atomic<int64_t> _top;
+	char _pad0[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<int64_t>)];
+	std::atomic<int64_t> _bottom;
+	std::atomic<buffer_t*> _buffer;
+	char _pad1[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<int64_t>) - sizeof(std::atomic<buffer_t*>)];
+
+	work_stealing_deque(const ref_t) = delete;
+	work_stealing_deque(rref_t) = delete;
+	ref_t operator=(const ref_t) = delete;
+	ref_t operator=(rref_t) = delete;
+};
+
+} // !namespace lockfree
+
+} // !namespace vee
+
+#pragma warning(default:4127)
+
+#endif // !_VEE_LOCKFREE_WORK_STEALING_DEQUE_H_
@@ -27,6 +27,28 @@ namespace vee {
 #endif
 #endif
 
+// Check Linux
+#if __linux__
+#define VEE_PLATFORM_LINUX 1
+#else
+#define VEE_PLATFORM_LINUX 0
+#endif
+
+// Destructive interference range used to keep hot atomics on separate cache lines
+#ifndef VEE_CACHE_LINE_SIZE
+#define VEE_CACHE_LINE_SIZE 64
+#endif
+
+// Contention and occupancy counters of the containers(vee/telemetry.h), compiled out by default
+#ifndef VEE_TELEMETRY
+#define VEE_TELEMETRY 0
+#endif
+
+// Random delays at the atomic points of the lockfree containers(vee/lockfree/stress.h), for the stress tests only
+#ifndef VEE_LOCKFREE_STRESS
+#define VEE_LOCKFREE_STRESS 0
+#endif
+
 } // !namespace vee
 
 #endif // !_VEE_PLATFORM_H_
\ No newline at end of file
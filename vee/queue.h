@@ -1,27 +1,38 @@
 #ifndef _VEE_QUEUE_H_
 #define _VEE_QUEUE_H_
 
+#include <vee/platform.h>
 #include <vee/lock.h>
+#include <vee/telemetry.h>
+#include <algorithm>
+#include <atomic>
 
 namespace vee {
 	
+/* The block locks are strided over the cache lines: the lock of the position pos lives in the line (pos % lines),
+   so the locks of neighbouring blocks, which are taken by consecutive enqueues and dequeues, never share a line.
+   A small queue gets a cache line for each block lock.
+   The occupancy counters(vee/telemetry.h) are compiled in with VEE_TELEMETRY; the spinning happens
+   inside the lock types, so the spin count of the telemetry stays zero. */
 template <class DataTy, class BlockLockTy = lock::spin_lock, class IndexLockTy = lock::spin_lock>
-class queue
+class queue: private telemetry::recorder_t
 {
 public:
-	using this_t = queue<DataTy, IndexLockTy>;
+	using this_t = queue<DataTy, BlockLockTy, IndexLockTy>;
 	using ref_t = this_t&;
 	using rref_t = this_t&&;
 	using data_t = DataTy;
 	using blocklock_t = BlockLockTy;
 	using idxlock_t = IndexLockTy;
+	static const size_t locks_per_line = (sizeof(blocklock_t) < VEE_CACHE_LINE_SIZE) ? VEE_CACHE_LINE_SIZE / sizeof(blocklock_t) : 1;
 	
 	explicit queue(const size_t capacity_, bool overwrite_flag = false):
 		capacity { capacity_ },
-		_overwrite_flag { overwrite_flag }
+		_overwrite_flag { overwrite_flag },
+		_lock_lines { _count_lock_lines(capacity_) }
 	{
 		_blocks = new data_t[capacity];
-		_blocklcks = new blocklock_t[capacity];
+		_blocklcks = new blocklock_t[_lock_lines * locks_per_line];
 	}
 	explicit queue(const ref_t other):
 		queue{ other.capacity, other._overwrite_flag }
@@ -37,11 +48,11 @@ public:
 	}
 	inline bool is_empty() const
 	{
-		return (_size == 0);
+		return (_size.load(std::memory_order_relaxed) == 0);
 	}
 	inline bool is_full() const
 	{
-		return _size == capacity;
+		return _size.load(std::memory_order_relaxed) == capacity;
 	}
 	template <class DataRef>
 	bool enqueue(DataRef&& val)
@@ -54,16 +65,21 @@ public:
 			if(is_full())
 			{
 				if (!_overwrite_flag)
+				{
+					count_full();
 					return false;
+				}
 				++_rear %= capacity;
 				++_front %= capacity;
 			}
 			else
 			{
 				++_rear %= capacity;
-				++_size;
+				const size_t size = _size.load(std::memory_order_relaxed) + 1;
+				_size.store(size, std::memory_order_relaxed);
+				peak(size);
 			}
-			std::unique_lock<blocklock_t> temp{_blocklcks[rear], std::adopt_lock};
+			std::unique_lock<blocklock_t> temp{ _blocklock(rear) };
 			std::swap(block_locker, temp);
 		}
 		_blocks[rear] = std::forward<DataRef>(val);
@@ -75,13 +91,17 @@ public:
 		std::unique_lock<blocklock_t> block_locker;
 		{
 			std::lock_guard<idxlock_t> idx_locker{ _idxlck };
-			if (!_size)
+			const size_t size = _size.load(std::memory_order_relaxed);
+			if (!size)
+			{
+				count_empty();
 				return false;
-			--_size;
+			}
+			_size.store(size - 1, std::memory_order_relaxed);
 			front = _front;
 			++_front %= capacity;
 
-			std::unique_lock<blocklock_t> temp{ _blocklcks[front], std::adopt_lock };
+			std::unique_lock<blocklock_t> temp{ _blocklock(front) };
 			std::swap(block_locker, temp);
 		}
 		using request_t = std::conditional_t<
@@ -91,15 +111,40 @@ public:
 		out = static_cast<request_t>(_blocks[front]);
 		return true;
 	}
+	// Read without the index lock, so the size may be stale when it returns
+	inline size_t guess_size() const
+	{
+		return _size.load(std::memory_order_relaxed);
+	}
+	telemetry::snapshot collect_telemetry() const
+	{
+		return telemetry_t::collect(guess_size());
+	}
+	void reset_telemetry()
+	{
+		telemetry_t::reset();
+	}
 	const size_t capacity;
 private:
+	using telemetry_t = telemetry::recorder_t;
+	static size_t _count_lock_lines(size_t capacity_)
+	{
+		const size_t per_line = locks_per_line;
+		return std::max<size_t>({ (capacity_ + per_line - 1) / per_line, std::min(capacity_, per_line), 1 });
+	}
+	inline blocklock_t& _blocklock(size_t pos)
+	{
+		return _blocklcks[(pos % _lock_lines) * locks_per_line + pos / _lock_lines];
+	}
+
 	data_t* _blocks = nullptr;
 	blocklock_t* _blocklcks = nullptr;
 	idxlock_t  _idxlck;
 	bool    _overwrite_flag = false;
+	size_t  _lock_lines = 1;
 	size_t  _front = 0;
 	size_t  _rear = 0;
-	size_t  _size = 0;
+	std::atomic<size_t> _size { 0 }; // written under the index lock, read without it by guess_size
 };
 
 } // !namespace vee
@@ -0,0 +1,210 @@
+#ifndef _VEE_TELEMETRY_H_
+#define _VEE_TELEMETRY_H_
+
+#include <vee/platform.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace vee {
+
+/* Contention and occupancy counters of the queues and the stacks
+   The containers record their events into a telemetry::recorder_t base, which is an empty class
+   unless VEE_TELEMETRY is set to 1, so a build without telemetry pays neither space nor time.
+   With telemetry, every thread increments the counters of its own shard(one cache line out of shard_count),
+   so the counters do not become a contention point of their own. The shards are allocated apart from
+   the container and aligned to the cache lines by hand, because the containers are allocated with a plain
+   new, which does not honour an over-aligned type before C++17. The occupancy is sampled on every
+   sample_interval-th operation of a thread, so the high-water mark is approximate. */
+namespace telemetry {
+
+// A point-in-time copy of the counters
+struct snapshot
+{
+	uint64_t cas_retries;    // lost claims of a position or a list head
+	uint64_t full_failures;  // enqueues(pushes) which gave up on a full container
+	uint64_t empty_failures; // dequeues(pops) which found the container empty
+	uint64_t spins;          // iterations spent waiting for room or for another thread
+	size_t high_water;       // the largest sampled occupancy
+	size_t size;             // the approximate occupancy when the snapshot was taken
+};
+
+template <bool Enabled>
+class recorder;
+
+template <>
+class recorder<false>
+{
+public:
+	void count_cas_retry() {}
+	void count_full() {}
+	void count_empty() {}
+	void count_spin(uint64_t = 1) {}
+	void count_added(size_t = 1) {}
+	void count_removed(size_t = 1) {}
+	size_t occupancy() const
+	{
+		return 0;
+	}
+	template <class SizeFn>
+	void sample(SizeFn&&) {}
+	void peak(size_t) {}
+	snapshot collect(size_t size) const
+	{
+		snapshot result{};
+		result.size = size;
+		return result;
+	}
+	void reset() {}
+};
+
+template <>
+class recorder<true>
+{
+public:
+	static const size_t shard_count = 16;
+	static const size_t sample_interval = 64;
+
+	recorder():
+		_buffer { new char[sizeof(shard_t) * shard_count + alignof(shard_t)] }
+	{
+		void* raw = _buffer;
+		size_t space = sizeof(shard_t) * shard_count + alignof(shard_t);
+		_shards = static_cast<shard_t*>(std::align(alignof(shard_t), sizeof(shard_t) * shard_count, raw, space));
+		for (size_t i = 0; i < shard_count; ++i)
+		{
+			::new (static_cast<void*>(_shards + i)) shard_t;
+			for (auto& value : _shards[i].values)
+				value.store(0, std::memory_order_relaxed);
+		}
+		_high_water.store(0, std::memory_order_relaxed);
+	}
+	~recorder()
+	{
+		delete[] _buffer;
+	}
+	void count_cas_retry()
+	{
+		_add(counter_cas_retries, 1);
+	}
+	void count_full()
+	{
+		_add(counter_full_failures, 1);
+	}
+	void count_empty()
+	{
+		_add(counter_empty_failures, 1);
+	}
+	void count_spin(uint64_t iterations = 1)
+	{
+		_add(counter_spins, iterations);
+	}
+	// Occupancy bookkeeping for the containers which cannot derive their size from positions
+	void count_added(size_t count = 1)
+	{
+		_add(counter_added, count);
+	}
+	void count_removed(size_t count = 1)
+	{
+		_add(counter_removed, count);
+	}
+	size_t occupancy() const
+	{
+		// The removals are summed up first, so that the concurrent pairs of add and remove rarely show up as a negative size
+		uint64_t added = 0, removed = 0;
+		for (size_t i = 0; i < shard_count; ++i)
+			removed += _shards[i].values[counter_removed].load(std::memory_order_relaxed);
+		for (size_t i = 0; i < shard_count; ++i)
+			added += _shards[i].values[counter_added].load(std::memory_order_relaxed);
+		return (added > removed) ? static_cast<size_t>(added - removed) : 0;
+	}
+	// Raises the high-water mark to size_fn() on every sample_interval-th call of the thread
+	template <class SizeFn>
+	void sample(SizeFn&& size_fn)
+	{
+		static thread_local size_t tick = 0;
+		if ((tick++ % sample_interval) == 0)
+			peak(size_fn());
+	}
+	void peak(size_t size)
+	{
+		size_t high = _high_water.load(std::memory_order_relaxed);
+		while (size > high && !_high_water.compare_exchange_weak(high, size, std::memory_order_relaxed));
+	}
+	snapshot collect(size_t size) const
+	{
+		snapshot result{};
+		for (size_t i = 0; i < shard_count; ++i)
+		{
+			const shard_t& it = _shards[i];
+			result.cas_retries += it.values[counter_cas_retries].load(std::memory_order_relaxed);
+			result.full_failures += it.values[counter_full_failures].load(std::memory_order_relaxed);
+			result.empty_failures += it.values[counter_empty_failures].load(std::memory_order_relaxed);
+			result.spins += it.values[counter_spins].load(std::memory_order_relaxed);
+		}
+		result.size = size;
+		result.high_water = _high_water.load(std::memory_order_relaxed);
+		if (result.high_water < size)
+			result.high_water = size;
+		return result;
+	}
+	// Clears the event counters and the high-water mark, the occupancy is kept
+	void reset()
+	{
+		for (size_t i = 0; i < shard_count; ++i)
+		{
+			for (size_t counter = 0; counter < counter_added; ++counter)
+				_shards[i].values[counter].store(0, std::memory_order_relaxed);
+		}
+		_high_water.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	enum : size_t
+	{
+		counter_cas_retries = 0,
+		counter_full_failures,
+		counter_empty_failures,
+		counter_spins,
+		counter_added,
+		counter_removed,
+		counter_count
+	};
+
+	struct alignas(VEE_CACHE_LINE_SIZE) shard_t
+	{
+		std::atomic<uint64_t> values[counter_count];
+	};
+
+	// A thread keeps the shard which it was given on its first record, for every recorder
+	static size_t _shard_index()
+	{
+		static std::atomic<size_t> next { 0 };
+		static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+		return index;
+	}
+
+	void _add(size_t counter, uint64_t count)
+	{
+		_shards[_shard_index()].values[counter].fetch_add(count, std::memory_order_relaxed);
+	}
+
+	char* _buffer;
+	shard_t* _shards; // shard_count shards inside _buffer, on their own cache lines
+	std::atomic<size_t> _high_water;
+	char _pad[VEE_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+	recorder(const recorder&) = delete;
+	recorder(recorder&&) = delete;
+	recorder& operator=(const recorder&) = delete;
+	recorder& operator=(recorder&&) = delete;
+};
+
+using recorder_t = recorder<VEE_TELEMETRY != 0>;
+
+} // !namespace telemetry
+
+} // !namespace vee
+
+#endif // !_VEE_TELEMETRY_H_
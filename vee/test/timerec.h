@@ -2,6 +2,7 @@
 #define _VEE_TEST_TIMEREC_H_
 
 #include <chrono>
+#include <utility>
 
 namespace vee {
 
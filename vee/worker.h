@@ -2,11 +2,14 @@
 #define _VEE_WORKER_H_
 
 #include <vee/delegate.h>
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/eventcount.h>
 #include <vee/lockfree/stack.h>
 #include <vee/exception.h>
 #include <thread>
 #include <future>
 #include <list>
+#include <vector>
 
 namespace vee {
  
@@ -121,11 +124,11 @@ public:
 
     struct events_wrapper
     {
-        using sleep_event_t = delegate<void(), lock::spin_lock>;
+        using sleep_event_t = delegate<void(), lock::shared_spin_lock>;
         sleep_event_t sleep;
-        using job_processed_event_t = delegate<void(), lock::spin_lock>;
+        using job_processed_event_t = delegate<void(), lock::shared_spin_lock>;
         job_processed_event_t job_processed;
-        using job_requested_event_t = delegate<void(), lock::spin_lock>;
+        using job_requested_event_t = delegate<void(), lock::shared_spin_lock>;
         job_requested_event_t job_requested;
     };
 
@@ -169,13 +172,7 @@ public:
         if (!result)
             return 0; // request failed, job queue is full
         size_t remained_old = _remained.fetch_add(1);
-        if ((remained_old == 0) && (_state.load() != state_t::standby))
-        {
-            while (this->_promise == nullptr)
-            {
-            }; // waiting until promise ready
-            _promise->set_value(); // signalling
-        }
+        _job_requested.notify_one(); // wakes the worker up if it sleeps
         events.job_requested.operator()();
         return remained_old + 1;
     }
@@ -221,23 +218,23 @@ public:
 private:
     void _worker_main()
     {
-        size_t remained = _remained.load();
         while (_state.load() == state_t::running)
         {
-            if (remained == 0)
+            if (_remained.load() == 0)
             {
-                auto promise = new std::make_shared<std::promise<void>>();
-                //auto promise = new std::promise<void>();
-                this->_promise = promise;
-                auto future = promise->get_future();
+                // The job count is checked again after prepare_wait, so a request cannot slip by the sleep
+                lockfree::eventcount::key_t key = _job_requested.prepare_wait();
+                if (_remained.load() != 0)
+                {
+                    _job_requested.cancel_wait();
+                    continue;
+                }
                 events.sleep.operator()();
-                puts("worker wait");
-                future.wait();
-                _promise.reset();
-                //delete promise;
+                _job_requested.commit_wait(key);
+                continue;
             }
             _epoch();
-            remained = _remained.fetch_sub(1) - 1;
+            _remained.fetch_sub(1);
         }
         state_t cmp{ state_t::shutdown };
         bool result = std::atomic_compare_exchange_strong(&_state, &cmp, state_t::standby);
@@ -264,8 +261,8 @@ public:
 private:
     std::atomic<size_t>  _remained;
     std::atomic<state_t> _state;
-    std::shared_ptr<std::promise<void>> _promise;
-    lockfree::queue<job_t> _job_queue;
+    lockfree::eventcount _job_requested;
+    lockfree::queue<job_t, lockfree::property::mpsc> _job_queue; // many requesters, one worker thread
     std::thread _thr;
 
 private:
@@ -0,0 +1,66 @@
+#ifndef _VEE_SAMPLES_LOCKFREE_BENCHMARK_H_
+#define _VEE_SAMPLES_LOCKFREE_BENCHMARK_H_
+
+#include <vee/test/timerec.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <cstdio>
+
+namespace bench {
+
+// Runs body(thread index) on the given number of threads which are released together,
+// and returns the elapsed seconds until the last thread finished
+template <class Body>
+double run_threads(size_t threads, Body&& body)
+{
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        pool.emplace_back([&go, &body, i]()
+        {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            body(i);
+        });
+    }
+    vee::test::timerec rec;
+    go.store(true, std::memory_order_release);
+    for (auto& it : pool)
+        it.join();
+    return rec.timelab().second;
+}
+
+// Monotonic timestamp for the latency measurements
+inline int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void report(const char* suite, const char* name, size_t threads, size_t ops, double seconds)
+{
+    printf("%-12s %-32s threads: %3u  ops: %10u  %8.3f Mops/s\n",
+           suite, name, static_cast<unsigned>(threads), static_cast<unsigned>(ops), ops / seconds / 1e6);
+}
+
+void bulk_suite();
+void reclamation_suite();
+void elimination_suite();
+void work_stealing_suite();
+void mailbox_suite();
+void wakeup_suite();
+void layout_suite();
+void pool_suite();
+void hash_map_suite();
+void seqlock_suite();
+void multicast_suite();
+void locks_suite();
+
+} // !namespace bench
+
+#endif // !_VEE_SAMPLES_LOCKFREE_BENCHMARK_H_
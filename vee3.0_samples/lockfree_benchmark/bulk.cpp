@@ -0,0 +1,90 @@
+#include "benchmark.h"
+#include <vee/lockfree/queue.h>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t queue_capacity = 4096;
+const size_t batch_size = 64;
+const size_t total_items = 1 << 21;
+
+// Per-item mode: every element costs one claim on each side
+double run_per_item(size_t threads)
+{
+    vee::lockfree::queue<uint64_t> q{ queue_capacity };
+    const size_t per_producer = total_items / threads;
+    std::atomic<size_t> consumed{ 0 };
+    return run_threads(threads * 2, [&](size_t id)
+    {
+        if (id < threads)
+        {
+            for (size_t i = 0; i < per_producer; ++i)
+            {
+                while (!q.enqueue(static_cast<uint64_t>(i)))
+                    std::this_thread::yield();
+            }
+            return;
+        }
+        uint64_t out = 0;
+        while (consumed.load(std::memory_order_relaxed) < per_producer * threads)
+        {
+            if (q.dequeue(out))
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            else
+                std::this_thread::yield();
+        }
+    });
+}
+
+// Bulk mode: a batch of elements costs one claim on each side
+double run_bulk(size_t threads)
+{
+    vee::lockfree::queue<uint64_t> q{ queue_capacity };
+    const size_t per_producer = total_items / threads;
+    std::atomic<size_t> consumed{ 0 };
+    return run_threads(threads * 2, [&](size_t id)
+    {
+        uint64_t batch[batch_size];
+        if (id < threads)
+        {
+            for (size_t i = 0; i < batch_size; ++i)
+                batch[i] = i;
+            size_t pushed = 0;
+            while (pushed < per_producer)
+            {
+                size_t request = (per_producer - pushed < batch_size) ? per_producer - pushed : batch_size;
+                size_t n = q.enqueue_bulk(batch, batch + request);
+                if (n == 0)
+                    std::this_thread::yield();
+                pushed += n;
+            }
+            return;
+        }
+        while (consumed.load(std::memory_order_relaxed) < per_producer * threads)
+        {
+            size_t n = q.dequeue_bulk(batch, batch_size);
+            if (n)
+                consumed.fetch_add(n, std::memory_order_relaxed);
+            else
+                std::this_thread::yield();
+        }
+    });
+}
+
+} // !unnamed namespace
+
+// Per-item vs bulk throughput with N producers and N consumers on one queue
+void bulk_suite()
+{
+    const size_t thread_counts[] = { 1, 4, 16 };
+    for (size_t threads : thread_counts)
+    {
+        size_t ops = (total_items / threads) * threads;
+        report("bulk", "queue::enqueue/dequeue", threads, ops, run_per_item(threads));
+        report("bulk", "queue::enqueue_bulk/dequeue_bulk", threads, ops, run_bulk(threads));
+    }
+}
+
+} // !namespace bench
@@ -0,0 +1,41 @@
+#include "benchmark.h"
+#include <cstring>
+
+namespace {
+
+struct suite_entry
+{
+    const char* name;
+    void(*run)();
+};
+
+const suite_entry suites[] = {
+    { "bulk", &bench::bulk_suite },
+    { "reclamation", &bench::reclamation_suite },
+    { "elimination", &bench::elimination_suite },
+    { "stealing", &bench::work_stealing_suite },
+    { "mailbox", &bench::mailbox_suite },
+    { "wakeup", &bench::wakeup_suite },
+    { "layout", &bench::layout_suite },
+    { "pool", &bench::pool_suite },
+    { "hash_map", &bench::hash_map_suite },
+    { "seqlock", &bench::seqlock_suite },
+    { "multicast", &bench::multicast_suite },
+    { "locks", &bench::locks_suite },
+};
+
+} // !unnamed namespace
+
+// usage: lockfree_benchmark [suite ...] (runs every suite without arguments)
+int main(int argc, char* argv[])
+{
+    for (auto& it : suites)
+    {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc; ++i)
+            selected |= (strcmp(argv[i], it.name) == 0);
+        if (selected)
+            it.run();
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "benchmark.h"
+#include <vee/lockfree/stack.h>
+
+namespace bench {
+
+namespace {
+
+const size_t ops_per_thread = 1 << 18;
+const size_t stack_capacity = 1024;
+
+// Every thread pushes and pops in turn, which is how the freelists are used on the allocation paths
+template <class StackTy>
+double run_symmetric(size_t threads)
+{
+    StackTy s{ stack_capacity };
+    for (size_t i = 0; i < stack_capacity / 2; ++i)
+        s.push(i);
+    return run_threads(threads, [&](size_t id)
+    {
+        size_t value = id;
+        for (size_t i = 0; i < ops_per_thread / 2; ++i)
+        {
+            while (!s.push(value))
+                std::this_thread::yield();
+            while (!s.pop(value))
+                std::this_thread::yield();
+        }
+    });
+}
+
+} // !unnamed namespace
+
+// Treiber stack with and without the elimination array under symmetric push/pop contention
+void elimination_suite()
+{
+    using plain_stack = vee::lockfree::stack<size_t>;
+    using elimination_stack = vee::lockfree::stack<size_t, vee::lockfree::property::mpmc, 16>;
+    const size_t thread_counts[] = { 2, 4, 8, 16, 32, 64 };
+    for (size_t threads : thread_counts)
+    {
+        size_t ops = ops_per_thread * threads;
+        report("elimination", "treiber", threads, ops, run_symmetric<plain_stack>(threads));
+        report("elimination", "treiber + elimination(16)", threads, ops, run_symmetric<elimination_stack>(threads));
+    }
+}
+
+} // !namespace bench
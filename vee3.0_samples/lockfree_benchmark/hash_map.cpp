@@ -0,0 +1,98 @@
+#include "benchmark.h"
+#include <vee/lockfree/hash_map.h>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t key_space = 1 << 16;
+const size_t total_ops = 1 << 21;
+
+// The table behind a mutex, as the connection tables are kept today
+class locked_map
+{
+public:
+    bool insert(uint64_t key, uint64_t value)
+    {
+        std::lock_guard<std::mutex> locker{ _lock };
+        return _map.emplace(key, value).second;
+    }
+    bool find(uint64_t key, uint64_t& out)
+    {
+        std::lock_guard<std::mutex> locker{ _lock };
+        auto it = _map.find(key);
+        if (it == _map.end())
+            return false;
+        out = it->second;
+        return true;
+    }
+    bool erase(uint64_t key)
+    {
+        std::lock_guard<std::mutex> locker{ _lock };
+        return _map.erase(key) != 0;
+    }
+private:
+    std::mutex _lock;
+    std::unordered_map<uint64_t, uint64_t> _map;
+};
+
+template <class Reclaimer>
+using lockfree_map = vee::lockfree::hash_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, Reclaimer>;
+
+// Every thread draws random keys, and a write_percent share of the operations insert or erase
+template <class MapTy>
+double run_mix(size_t threads, size_t write_percent)
+{
+    MapTy map;
+    for (uint64_t key = 0; key < key_space; key += 2)
+        map.insert(key, key);
+    const size_t per_thread = total_ops / threads;
+    return run_threads(threads, [&](size_t id)
+    {
+        uint64_t seed = id * 0x9E3779B97F4A7C15ULL + 1;
+        uint64_t out = 0;
+        for (size_t i = 0; i < per_thread; ++i)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            const uint64_t key = seed % key_space;
+            if ((seed >> 32) % 100 >= write_percent)
+                map.find(key, out);
+            else if ((seed >> 40) & 1)
+                map.insert(key, key);
+            else
+                map.erase(key);
+        }
+    });
+}
+
+void report_mix(const char* mix, size_t write_percent)
+{
+    const size_t thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    for (size_t threads : thread_counts)
+    {
+        size_t ops = (total_ops / threads) * threads;
+        char name[64];
+        snprintf(name, sizeof(name), "%s mutex+unordered_map", mix);
+        report("hash_map", name, threads, ops, run_mix<locked_map>(threads, write_percent));
+        snprintf(name, sizeof(name), "%s hash_map<ebr>", mix);
+        report("hash_map", name, threads, ops, run_mix<lockfree_map<vee::lockfree::ebr>>(threads, write_percent));
+        snprintf(name, sizeof(name), "%s hash_map<hazard_pointer>", mix);
+        report("hash_map", name, threads, ops, run_mix<lockfree_map<vee::lockfree::hazard_pointer>>(threads, write_percent));
+    }
+}
+
+} // !unnamed namespace
+
+// Read-heavy(95% find) and write-heavy(50% insert/erase) mixes on a table which is half full
+void hash_map_suite()
+{
+    report_mix("95/5", 5);
+    report_mix("50/50", 50);
+}
+
+} // !namespace bench
@@ -0,0 +1,97 @@
+#include "benchmark.h"
+#include <vee/lockfree/queue.h>
+#include <vee/queue.h>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+// Not a power of two, so that the exact layout pays an integer division for every index
+const size_t queue_capacity = 3000;
+const size_t total_items = 1 << 22;
+
+using exact_mpmc = vee::lockfree::atqueue<uint64_t, vee::lockfree::property::mpmc, vee::lockfree::property::exact_capacity>;
+using pow2_mpmc = vee::lockfree::atqueue<uint64_t, vee::lockfree::property::mpmc, vee::lockfree::property::pow2_capacity>;
+using exact_spsc = vee::lockfree::atqueue<uint64_t, vee::lockfree::property::spsc, vee::lockfree::property::exact_capacity>;
+using pow2_spsc = vee::lockfree::atqueue<uint64_t, vee::lockfree::property::spsc, vee::lockfree::property::pow2_capacity>;
+
+// A single thread enqueues and dequeues in turn, so that the index arithmetic dominates
+template <class QueueTy>
+double run_single(QueueTy& q)
+{
+    return run_threads(1, [&](size_t)
+    {
+        uint64_t out = 0;
+        for (size_t i = 0; i < total_items; i += 64)
+        {
+            for (size_t j = 0; j < 64; ++j)
+                q.enqueue(static_cast<uint64_t>(j));
+            for (size_t j = 0; j < 64; ++j)
+                q.dequeue(out);
+        }
+    });
+}
+
+template <class QueueTy>
+double run_pairs(QueueTy& q, size_t threads)
+{
+    const size_t per_producer = total_items / threads;
+    std::atomic<size_t> consumed{ 0 };
+    return run_threads(threads * 2, [&](size_t id)
+    {
+        if (id < threads)
+        {
+            for (size_t i = 0; i < per_producer; ++i)
+            {
+                while (!q.enqueue(static_cast<uint64_t>(i)))
+                    std::this_thread::yield();
+            }
+            return;
+        }
+        uint64_t out = 0;
+        while (consumed.load(std::memory_order_relaxed) < per_producer * threads)
+        {
+            if (q.dequeue(out))
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            else
+                std::this_thread::yield();
+        }
+    });
+}
+
+template <class QueueTy>
+void report_single(const char* name)
+{
+    QueueTy q{ queue_capacity };
+    report("layout", name, 1, total_items * 2, run_single(q));
+}
+
+template <class QueueTy>
+void report_pairs(const char* name, size_t threads)
+{
+    QueueTy q{ queue_capacity };
+    report("layout", name, threads, (total_items / threads) * threads, run_pairs(q, threads));
+}
+
+} // !unnamed namespace
+
+// Modulo(exact capacity) against mask(power-of-two capacity) indexing, before and after for every ring
+void layout_suite()
+{
+    report_single<exact_mpmc>("atqueue<mpmc> exact(single)");
+    report_single<pow2_mpmc>("atqueue<mpmc> pow2(single)");
+    report_single<exact_spsc>("atqueue<spsc> exact(single)");
+    report_single<pow2_spsc>("atqueue<spsc> pow2(single)");
+    report_pairs<exact_spsc>("atqueue<spsc> exact", 1);
+    report_pairs<pow2_spsc>("atqueue<spsc> pow2", 1);
+    const size_t thread_counts[] = { 1, 4 };
+    for (size_t threads : thread_counts)
+    {
+        report_pairs<exact_mpmc>("atqueue<mpmc> exact", threads);
+        report_pairs<pow2_mpmc>("atqueue<mpmc> pow2", threads);
+        report_pairs<vee::queue<uint64_t>>("vee::queue(strided block locks)", threads);
+    }
+}
+
+} // !namespace bench
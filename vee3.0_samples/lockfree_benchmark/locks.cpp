@@ -0,0 +1,78 @@
+#include "benchmark.h"
+#include <vee/lock.h>
+#include <vee/lock_profile.h>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t total_acquisitions = 1 << 16;
+
+// The state which the critical section updates, two cache lines like a small queue index
+struct shared_state_t
+{
+    uint64_t counter;
+    uint64_t values[15];
+};
+
+// Every thread takes the lock in a loop with a short pause between the critical sections,
+// and returns the elapsed seconds; worst_ns receives the longest wait for the lock of any thread
+template <class LockTy>
+double run_lock(size_t threads, int64_t& worst_ns)
+{
+    LockTy lock;
+    shared_state_t state{};
+    const size_t per_thread = total_acquisitions / threads;
+    std::vector<int64_t> worst(threads, 0);
+    const double seconds = run_threads(threads, [&](size_t id)
+    {
+        int64_t longest = 0;
+        for (size_t i = 0; i < per_thread; ++i)
+        {
+            const int64_t begin = now_ns();
+            lock.lock();
+            longest = std::max(longest, now_ns() - begin);
+            ++state.counter;
+            state.values[state.counter % 15] += id;
+            lock.unlock();
+            for (volatile size_t spin = 0; spin < 64; ++spin);
+        }
+        worst[id] = longest;
+    });
+    worst_ns = *std::max_element(worst.begin(), worst.end());
+    return seconds;
+}
+
+template <class LockTy>
+void report_lock(const char* name, size_t threads)
+{
+    int64_t worst_ns = 0;
+    const size_t ops = (total_acquisitions / threads) * threads;
+    report("locks", name, threads, ops, run_lock<LockTy>(threads, worst_ns));
+    printf("%-12s %-32s threads: %3u  worst acquisition: %10.1f us\n", "locks", name, static_cast<unsigned>(threads), worst_ns / 1e3);
+}
+
+} // !unnamed namespace
+
+// Throughput and the worst acquisition latency of the LockTy choices, from 2 up to 64 threads,
+// and the cost of the profiling wrapper
+void locks_suite()
+{
+    const size_t thread_counts[] = { 2, 4, 8, 16, 32, 64 };
+    for (size_t threads : thread_counts)
+    {
+        report_lock<std::mutex>("std::mutex", threads);
+        report_lock<vee::lock::spin_lock>("spin_lock", threads);
+        report_lock<vee::lock::ticket_lock>("ticket_lock", threads);
+        report_lock<vee::lock::mcs_lock>("mcs_lock", threads);
+        report_lock<vee::lock::cohort_lock>("cohort_lock", threads);
+        report_lock<vee::lock::profiled<vee::lock::spin_lock>>("profiled<spin_lock>", threads);
+    }
+    // The profiled runs of every thread count, under the default name
+    vee::lock::profile_registry::instance().dump();
+}
+
+} // !namespace bench
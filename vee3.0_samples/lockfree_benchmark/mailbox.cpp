@@ -0,0 +1,97 @@
+#include "benchmark.h"
+#include <vee/lockfree/mailbox.h>
+#include <vee/lockfree/queue.h>
+#include <memory>
+
+namespace bench {
+
+namespace {
+
+const size_t messages_per_producer = 1 << 18;
+
+struct message_t: vee::lockfree::mailbox_hook
+{
+    size_t payload;
+};
+
+// Thread 0 consumes every message, the others produce
+double run_mailbox(size_t producers)
+{
+    vee::lockfree::mailbox<message_t> box;
+    std::vector<message_t> messages(producers * messages_per_producer);
+    const size_t total = messages.size();
+    return run_threads(producers + 1, [&](size_t id)
+    {
+        if (id == 0)
+        {
+            size_t received = 0, sum = 0;
+            while (received < total)
+            {
+                size_t drained = box.drain([&](message_t* msg) { sum += msg->payload; });
+                if (drained == 0)
+                    std::this_thread::yield();
+                received += drained;
+            }
+            return;
+        }
+        message_t* mine = &messages[(id - 1) * messages_per_producer];
+        for (size_t i = 0; i < messages_per_producer; ++i)
+        {
+            mine[i].payload = i;
+            box.push(&mine[i]);
+        }
+    });
+}
+
+// The former way: the messages are shared_ptrs which are copied through a bounded mpsc queue
+double run_shared_ptr_queue(size_t producers)
+{
+    using message_ptr = std::shared_ptr<message_t>;
+    vee::lockfree::queue<message_ptr, vee::lockfree::property::mpsc> q{ 1024 };
+    std::vector<message_ptr> messages(producers * messages_per_producer);
+    for (auto& it : messages)
+        it = std::make_shared<message_t>();
+    const size_t total = messages.size();
+    return run_threads(producers + 1, [&](size_t id)
+    {
+        if (id == 0)
+        {
+            size_t received = 0, sum = 0;
+            message_ptr msg;
+            while (received < total)
+            {
+                if (q.dequeue(msg))
+                {
+                    sum += msg->payload;
+                    ++received;
+                }
+                else
+                    std::this_thread::yield();
+            }
+            return;
+        }
+        for (size_t i = 0; i < messages_per_producer; ++i)
+        {
+            message_ptr& msg = messages[(id - 1) * messages_per_producer + i];
+            msg->payload = i;
+            while (!q.enqueue(msg))
+                std::this_thread::yield();
+        }
+    });
+}
+
+} // !unnamed namespace
+
+// Many producers and one consumer, the intrusive mailbox against a queue of shared_ptrs
+void mailbox_suite()
+{
+    const size_t producer_counts[] = { 1, 2, 4, 8 };
+    for (size_t producers : producer_counts)
+    {
+        size_t ops = producers * messages_per_producer;
+        report("mailbox", "intrusive mailbox", producers + 1, ops, run_mailbox(producers));
+        report("mailbox", "queue<shared_ptr>", producers + 1, ops, run_shared_ptr_queue(producers));
+    }
+}
+
+} // !namespace bench
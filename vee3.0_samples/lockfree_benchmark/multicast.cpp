@@ -0,0 +1,100 @@
+#include "benchmark.h"
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/multicast_ring.h>
+#include <memory>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t ring_capacity = 4096;
+const size_t total_messages = 1 << 20;
+
+// A market-data update sized message
+struct tick_t
+{
+    uint64_t sequence;
+    uint64_t fields[7];
+};
+
+// The former fan-out: a spsc queue and a copy of the message for every consumer
+double run_queue_per_consumer(size_t consumers)
+{
+    using queue_t = vee::lockfree::atqueue<tick_t, vee::lockfree::property::spsc, vee::lockfree::property::pow2_capacity>;
+    std::vector<std::unique_ptr<queue_t>> queues;
+    for (size_t i = 0; i < consumers; ++i)
+        queues.emplace_back(new queue_t(ring_capacity));
+    return run_threads(consumers + 1, [&](size_t id)
+    {
+        if (id == consumers)
+        {
+            tick_t tick{};
+            for (size_t i = 0; i < total_messages; ++i)
+            {
+                tick.sequence = i;
+                for (auto& q : queues)
+                {
+                    while (!q->enqueue(tick))
+                        std::this_thread::yield();
+                }
+            }
+            return;
+        }
+        tick_t out;
+        uint64_t sum = 0;
+        for (size_t received = 0; received < total_messages; )
+        {
+            if (queues[id]->dequeue(out))
+            {
+                sum += out.sequence;
+                ++received;
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+}
+
+template <class WaitTy>
+double run_multicast(size_t consumers, size_t batch)
+{
+    vee::lockfree::multicast_ring<tick_t, vee::lockfree::property::SingleCore, WaitTy> ring{ ring_capacity };
+    std::vector<typename decltype(ring)::consumer*> subscribers;
+    for (size_t i = 0; i < consumers; ++i)
+        subscribers.push_back(&ring.subscribe());
+    return run_threads(consumers + 1, [&](size_t id)
+    {
+        if (id == consumers)
+        {
+            for (size_t i = 0; i < total_messages; i += batch)
+            {
+                const size_t first = ring.claim(batch);
+                for (size_t j = 0; j < batch; ++j)
+                    ring[first + j].sequence = i + j;
+                ring.publish(first, batch);
+            }
+            return;
+        }
+        uint64_t sum = 0;
+        for (size_t received = 0; received < total_messages; )
+            received += subscribers[id]->consume([&](tick_t& tick, size_t) { sum += tick.sequence; });
+    });
+}
+
+} // !unnamed namespace
+
+// One producer fans every message out to all consumers, the throughput counts the messages per consumer
+void multicast_suite()
+{
+    const size_t consumer_counts[] = { 1, 2, 4 };
+    for (size_t consumers : consumer_counts)
+    {
+        report("multicast", "atqueue<spsc> per consumer", consumers, total_messages, run_queue_per_consumer(consumers));
+        report("multicast", "multicast_ring(yield)", consumers, total_messages, run_multicast<vee::lockfree::wait_strategy::yield>(consumers, 1));
+        report("multicast", "multicast_ring(yield, batch 16)", consumers, total_messages, run_multicast<vee::lockfree::wait_strategy::yield>(consumers, 16));
+        report("multicast", "multicast_ring(block, batch 16)", consumers, total_messages, run_multicast<vee::lockfree::wait_strategy::block>(consumers, 16));
+    }
+}
+
+} // !namespace bench
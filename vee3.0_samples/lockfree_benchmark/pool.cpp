@@ -0,0 +1,70 @@
+#include "benchmark.h"
+#include <vee/lockfree/object_pool.h>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t objects_per_round = 16;
+const size_t total_objects = 1 << 22;
+
+// A job or io buffer sized payload
+struct payload_t
+{
+    uint64_t words[8];
+    explicit payload_t(uint64_t seed)
+    {
+        for (auto& it : words)
+            it = seed;
+    }
+};
+
+// Every thread allocates a round of objects, then frees them in the allocation order
+template <class AllocFn, class FreeFn>
+double run_rounds(size_t threads, AllocFn&& alloc, FreeFn&& free)
+{
+    const size_t rounds = total_objects / objects_per_round / threads;
+    return run_threads(threads, [&](size_t id)
+    {
+        payload_t* held[objects_per_round];
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < objects_per_round; ++i)
+                held[i] = alloc(id);
+            for (size_t i = 0; i < objects_per_round; ++i)
+                free(held[i]);
+        }
+    });
+}
+
+double run_heap(size_t threads)
+{
+    return run_rounds(threads,
+                      [](size_t id) { return new payload_t(id); },
+                      [](payload_t* ptr) { delete ptr; });
+}
+
+double run_pool(size_t threads)
+{
+    vee::lockfree::object_pool<payload_t> pool{ threads * (objects_per_round + 2 * 32) };
+    return run_rounds(threads,
+                      [&](size_t id) { return pool.create(id); },
+                      [&](payload_t* ptr) { pool.destroy(ptr); });
+}
+
+} // !unnamed namespace
+
+// Allocation throughput of the object pool against the global heap
+void pool_suite()
+{
+    const size_t thread_counts[] = { 1, 4, 16 };
+    for (size_t threads : thread_counts)
+    {
+        size_t ops = (total_objects / objects_per_round / threads) * objects_per_round * threads;
+        report("pool", "new/delete", threads, ops, run_heap(threads));
+        report("pool", "object_pool::create/destroy", threads, ops, run_pool(threads));
+    }
+}
+
+} // !namespace bench
@@ -0,0 +1,153 @@
+#include "benchmark.h"
+#include <vee/lockfree/ebr.h>
+#include <vee/lockfree/hazard_pointer.h>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t ops_per_thread = 1 << 20;
+
+struct node_t
+{
+    explicit node_t(uint64_t v):
+        value{ v }
+    {
+    }
+    uint64_t value;
+};
+
+// Baseline: the replaced nodes are only freed after the run, so no reclamation work is done on the hot path
+struct leak_scheme
+{
+    struct guard
+    {
+        node_t* protect(const std::atomic<node_t*>& src) const
+        {
+            return src.load(std::memory_order_acquire);
+        }
+    };
+    static void retire(node_t* ptr, std::vector<node_t*>& graveyard)
+    {
+        graveyard.push_back(ptr);
+    }
+};
+
+// Adapts a reclaimer of vee::lockfree (ebr or hazard_pointer)
+template <class ReclaimerTy>
+struct reclaimer_scheme
+{
+    using guard = typename ReclaimerTy::guard;
+    static void retire(node_t* ptr, std::vector<node_t*>& /*graveyard*/)
+    {
+        ReclaimerTy::retire(ptr);
+    }
+};
+
+using ebr_scheme = reclaimer_scheme<vee::lockfree::ebr>;
+using hp_scheme = reclaimer_scheme<vee::lockfree::hazard_pointer>;
+
+// Every thread reads the shared node, and replaces it with the given probability (per mille)
+template <class SchemeTy>
+double run_mix(size_t threads, unsigned write_permille)
+{
+    std::atomic<node_t*> shared{ new node_t{ 0 } };
+    std::vector<std::vector<node_t*>> graveyards(threads);
+    std::atomic<uint64_t> checksum{ 0 };
+    double seconds = run_threads(threads, [&](size_t id)
+    {
+        uint64_t x = 88172645463325252ULL + id, sum = 0;
+        for (size_t i = 0; i < ops_per_thread; ++i)
+        {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            typename SchemeTy::guard guard;
+            if ((x % 1000) < write_permille)
+            {
+                node_t* old = shared.exchange(new node_t{ i }, std::memory_order_acq_rel);
+                SchemeTy::retire(old, graveyards[id]);
+            }
+            else
+                sum += guard.protect(shared)->value;
+        }
+        checksum.fetch_add(sum, std::memory_order_relaxed);
+    });
+    for (auto& graveyard : graveyards)
+        for (auto it : graveyard)
+            delete it;
+    delete shared.load();
+    vee::lockfree::ebr::synchronize();
+    vee::lockfree::hazard_pointer::synchronize();
+    return seconds;
+}
+
+// One reader stays inside a guard while the writers keep replacing the shared node,
+// and returns the number of the objects which the reclaimer could not free meanwhile
+template <class ReclaimerTy>
+size_t run_stalled_reader(size_t writers)
+{
+    std::atomic<node_t*> shared{ new node_t{ 0 } };
+    std::atomic<int> phase{ 0 };
+    std::thread reader([&]()
+    {
+        typename ReclaimerTy::guard guard;
+        guard.protect(shared);
+        phase.store(1);
+        while (phase.load() != 2)
+            std::this_thread::yield();
+    });
+    while (phase.load() != 1)
+        std::this_thread::yield();
+    size_t before = ReclaimerTy::guess_pending();
+    run_threads(writers, [&](size_t /*id*/)
+    {
+        for (size_t i = 0; i < ops_per_thread / 16; ++i)
+            ReclaimerTy::retire(shared.exchange(new node_t{ i }, std::memory_order_acq_rel));
+        ReclaimerTy::flush();
+    });
+    size_t result = ReclaimerTy::guess_pending() - before;
+    phase.store(2);
+    reader.join();
+    delete shared.load();
+    ReclaimerTy::synchronize();
+    return result;
+}
+
+} // !unnamed namespace
+
+// Reclamation overhead of ebr and hazard pointers against a scheme which never reclaims on the hot path,
+// and the memory which they hold back while a reader is stalled
+void reclamation_suite()
+{
+    const size_t thread_counts[] = { 1, 2, 4, 8 };
+    const struct { const char* name; unsigned write_permille; } mixes[] = {
+        { "read-heavy(95/5)", 50 },
+        { "write-heavy(50/50)", 500 },
+    };
+    char name[64];
+    for (auto& mix : mixes)
+    {
+        for (size_t threads : thread_counts)
+        {
+            size_t ops = ops_per_thread * threads;
+            snprintf(name, sizeof(name), "leak %s", mix.name);
+            report("reclamation", name, threads, ops, run_mix<leak_scheme>(threads, mix.write_permille));
+            snprintf(name, sizeof(name), "ebr %s", mix.name);
+            report("reclamation", name, threads, ops, run_mix<ebr_scheme>(threads, mix.write_permille));
+            snprintf(name, sizeof(name), "hp %s", mix.name);
+            report("reclamation", name, threads, ops, run_mix<hp_scheme>(threads, mix.write_permille));
+        }
+    }
+    for (size_t writers : thread_counts)
+    {
+        printf("reclamation  stalled reader, writers: %3u  retired: %10u  held back by ebr: %10u  by hp: %5u\n",
+               static_cast<unsigned>(writers), static_cast<unsigned>(writers * (ops_per_thread / 16)),
+               static_cast<unsigned>(run_stalled_reader<vee::lockfree::ebr>(writers)),
+               static_cast<unsigned>(run_stalled_reader<vee::lockfree::hazard_pointer>(writers)));
+    }
+    printf("reclamation  pending objects after the suite: ebr %u, hp %u\n",
+           static_cast<unsigned>(vee::lockfree::ebr::guess_pending()),
+           static_cast<unsigned>(vee::lockfree::hazard_pointer::guess_pending()));
+}
+
+} // !namespace bench
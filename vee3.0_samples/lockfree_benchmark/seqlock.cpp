@@ -0,0 +1,103 @@
+#include "benchmark.h"
+#include <vee/lock.h>
+#include <mutex>
+#include <shared_mutex>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t total_reads = 1 << 23;
+
+// A rate table sized snapshot, read on every packet and rewritten rarely
+struct rates_t
+{
+    uint64_t values[8];
+};
+
+class spin_locked
+{
+public:
+    rates_t load()
+    {
+        std::lock_guard<vee::lock::spin_lock> locker{ _lock };
+        return _data;
+    }
+    void store(const rates_t& value)
+    {
+        std::lock_guard<vee::lock::spin_lock> locker{ _lock };
+        _data = value;
+    }
+private:
+    vee::lock::spin_lock _lock;
+    rates_t _data{};
+};
+
+// The readers take the shared lock, the writer the exclusive one
+template <class LockTy>
+class shared_locked
+{
+public:
+    rates_t load()
+    {
+        vee::lock::shared_guard<LockTy> locker{ _lock };
+        return _data;
+    }
+    void store(const rates_t& value)
+    {
+        std::lock_guard<LockTy> locker{ _lock };
+        _data = value;
+    }
+private:
+    LockTy _lock;
+    rates_t _data{};
+};
+
+// The readers load the snapshot in a loop while one more thread rewrites it every 100us
+template <class GuardTy>
+double run_readers(size_t readers)
+{
+    GuardTy guard;
+    const size_t per_reader = total_reads / readers;
+    std::atomic<size_t> readers_done{ 0 };
+    std::atomic<uint64_t> sink{ 0 };
+    return run_threads(readers + 1, [&](size_t id)
+    {
+        if (id == readers)
+        {
+            rates_t next{};
+            while (readers_done.load(std::memory_order_relaxed) != readers)
+            {
+                for (auto& it : next.values)
+                    ++it;
+                guard.store(next);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            return;
+        }
+        uint64_t sum = 0;
+        for (size_t i = 0; i < per_reader; ++i)
+            sum += guard.load().values[i & 7];
+        sink.fetch_add(sum, std::memory_order_relaxed);
+        readers_done.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
+} // !unnamed namespace
+
+// Reader throughput of a read-mostly snapshot under spin_lock, the reader-writer locks and seqlock
+void seqlock_suite()
+{
+    const size_t thread_counts[] = { 1, 2, 4, 8, 16 };
+    for (size_t readers : thread_counts)
+    {
+        size_t ops = (total_reads / readers) * readers;
+        report("seqlock", "spin_lock", readers, ops, run_readers<spin_locked>(readers));
+        report("seqlock", "std::shared_timed_mutex", readers, ops, run_readers<shared_locked<std::shared_timed_mutex>>(readers));
+        report("seqlock", "shared_spin_lock", readers, ops, run_readers<shared_locked<vee::lock::shared_spin_lock>>(readers));
+        report("seqlock", "seqlock", readers, ops, run_readers<vee::lock::seqlock<rates_t>>(readers));
+    }
+}
+
+} // !namespace bench
@@ -0,0 +1,72 @@
+#include "benchmark.h"
+#include <vee/lockfree/blocking.h>
+
+namespace bench {
+
+namespace {
+
+const size_t samples = 1000;
+
+// The producer sends a timestamp while the consumer is idle, and the consumer sums up the latency(ns)
+template <class ProduceFn, class ConsumeFn>
+double run_wakeup(ProduceFn&& produce, ConsumeFn&& consume)
+{
+    std::atomic<int64_t> total_ns{ 0 };
+    run_threads(2, [&](size_t id)
+    {
+        if (id == 0)
+        {
+            for (size_t i = 0; i < samples; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                produce(now_ns());
+            }
+            return;
+        }
+        for (size_t i = 0; i < samples; ++i)
+        {
+            int64_t stamp = consume();
+            total_ns.fetch_add(now_ns() - stamp, std::memory_order_relaxed);
+        }
+    });
+    return static_cast<double>(total_ns.load()) / samples;
+}
+
+double run_eventcount()
+{
+    vee::lockfree::blocking<vee::lockfree::queue<int64_t>> q{ 16 };
+    return run_wakeup([&](int64_t stamp) { q.enqueue(stamp); },
+                      [&]()
+                      {
+                          int64_t stamp = 0;
+                          q.dequeue_wait(stamp);
+                          return stamp;
+                      });
+}
+
+// The former way of an idle consumer: polls the queue and sleeps between the polls
+double run_sleep_poll()
+{
+    vee::lockfree::queue<int64_t> q{ 16 };
+    return run_wakeup([&](int64_t stamp) { q.enqueue(stamp); },
+                      [&]()
+                      {
+                          int64_t stamp = 0;
+                          while (!q.dequeue(stamp))
+                              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                          return stamp;
+                      });
+}
+
+} // !unnamed namespace
+
+// Latency until an idle consumer takes an item, sleeping on an eventcount against polling with a sleep
+void wakeup_suite()
+{
+    printf("%-12s %-32s samples: %6u  %10.1f ns\n", "wakeup", "eventcount(dequeue_wait)",
+           static_cast<unsigned>(samples), run_eventcount());
+    printf("%-12s %-32s samples: %6u  %10.1f ns\n", "wakeup", "sleep-poll(1ms)",
+           static_cast<unsigned>(samples), run_sleep_poll());
+}
+
+} // !namespace bench
@@ -0,0 +1,95 @@
+#include "benchmark.h"
+#include <vee/lockfree/work_stealing_deque.h>
+#include <cstdint>
+
+namespace bench {
+
+namespace {
+
+const size_t items_per_run = 1 << 20;
+const size_t latency_samples = 1 << 14;
+
+// The owner pushes batches and works them off from the bottom while the thieves steal from the top
+double run_throughput(size_t thieves)
+{
+    vee::lockfree::work_stealing_deque<size_t> d;
+    std::atomic<size_t> taken{ 0 };
+    return run_threads(thieves + 1, [&](size_t id)
+    {
+        size_t out = 0, local = 0;
+        if (id == 0)
+        {
+            for (size_t i = 0; i < items_per_run; ++i)
+            {
+                d.push(i);
+                if ((i % 64) == 63)
+                {
+                    while (d.pop(out))
+                        ++local;
+                }
+            }
+            while (d.pop(out))
+                ++local;
+            taken.fetch_add(local, std::memory_order_relaxed);
+            return;
+        }
+        while (taken.load(std::memory_order_relaxed) < items_per_run)
+        {
+            if (d.steal(out))
+                taken.fetch_add(1, std::memory_order_relaxed);
+            else
+                std::this_thread::yield();
+        }
+    });
+}
+
+// The owner pushes a timestamp and waits until a thief has stolen it, returns the average latency(ns)
+double run_steal_latency()
+{
+    vee::lockfree::work_stealing_deque<int64_t> d;
+    std::atomic<size_t> stolen{ 0 };
+    std::atomic<int64_t> total_ns{ 0 };
+    run_threads(2, [&](size_t id)
+    {
+        if (id == 0)
+        {
+            for (size_t i = 0; i < latency_samples; ++i)
+            {
+                d.push(now_ns());
+                while (stolen.load(std::memory_order_acquire) == i)
+                    std::this_thread::yield();
+            }
+            return;
+        }
+        int64_t stamp = 0;
+        while (stolen.load(std::memory_order_relaxed) < latency_samples)
+        {
+            if (d.steal(stamp))
+            {
+                total_ns.fetch_add(now_ns() - stamp, std::memory_order_relaxed);
+                stolen.fetch_add(1, std::memory_order_release);
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+    return static_cast<double>(total_ns.load()) / latency_samples;
+}
+
+} // !unnamed namespace
+
+// Throughput of the Chase-Lev deque with a growing number of thieves, and the push-to-steal latency
+void work_stealing_suite()
+{
+    const size_t thief_counts[] = { 0, 1, 2, 4, 8 };
+    char name[64];
+    for (size_t thieves : thief_counts)
+    {
+        snprintf(name, sizeof(name), "owner + %u thieves", static_cast<unsigned>(thieves));
+        report("stealing", name, thieves + 1, items_per_run, run_throughput(thieves));
+    }
+    printf("%-12s %-32s samples: %6u  %8.1f ns\n", "stealing", "push-to-steal latency",
+           static_cast<unsigned>(latency_samples), run_steal_latency());
+}
+
+} // !namespace bench
@@ -0,0 +1,191 @@
+#ifndef _VEE_SAMPLES_LOCKFREE_STRESS_CHECKER_H_
+#define _VEE_SAMPLES_LOCKFREE_STRESS_CHECKER_H_
+
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <set>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+
+namespace stress_test {
+
+// A completed push or pop, the times come from a logical clock which every operation reads before and after itself
+struct operation
+{
+    size_t thread;
+    bool push;
+    bool ok;         // false: the push found the container full, or the pop found it empty
+    uint64_t value;  // the pushed or the popped value
+    uint64_t invoke;
+    uint64_t response;
+};
+
+class history
+{
+public:
+    explicit history(size_t threads):
+        _ops(threads)
+    {
+    }
+    // Returns the invoke time of an operation of the thread
+    uint64_t begin()
+    {
+        return _clock.fetch_add(1, std::memory_order_seq_cst);
+    }
+    void end(size_t thread, uint64_t invoke, bool push, bool ok, uint64_t value)
+    {
+        const uint64_t response = _clock.fetch_add(1, std::memory_order_seq_cst);
+        _ops[thread].push_back(operation{ thread, push, ok, value, invoke, response });
+    }
+    std::vector<operation> merge() const
+    {
+        std::vector<operation> result;
+        for (auto& it : _ops)
+            result.insert(result.end(), it.begin(), it.end());
+        return result;
+    }
+private:
+    std::atomic<uint64_t> _clock{ 0 };
+    std::vector<std::vector<operation>> _ops; // every thread appends to its own list
+};
+
+// The sequential specifications, a bounded FIFO queue and a bounded LIFO stack
+struct fifo_model
+{
+    static const char* name()
+    {
+        return "FIFO";
+    }
+    static uint64_t peek(const std::deque<uint64_t>& state)
+    {
+        return state.front();
+    }
+    static void remove(std::deque<uint64_t>& state)
+    {
+        state.pop_front();
+    }
+    static void restore(std::deque<uint64_t>& state, uint64_t value)
+    {
+        state.push_front(value);
+    }
+};
+
+struct lifo_model
+{
+    static const char* name()
+    {
+        return "LIFO";
+    }
+    static uint64_t peek(const std::deque<uint64_t>& state)
+    {
+        return state.back();
+    }
+    static void remove(std::deque<uint64_t>& state)
+    {
+        state.pop_back();
+    }
+    static void restore(std::deque<uint64_t>& state, uint64_t value)
+    {
+        state.push_back(value);
+    }
+};
+
+/* Searches for a sequential order of the history which respects the real-time order and the model(Wing & Gong).
+   A successful operation must be legal at its linearization point. The full and empty answers are allowed to be
+   spurious, because the ring queues report full while a consumer of the previous lap is still reading its slot
+   and empty while an earlier producer is still writing; a failed operation only must not change the contents.
+   The history must end with a drain of the container, so nothing may be left in the model at the end.
+   The search memoizes the visited pairs of linearized set and contents, the histories are kept under 64 operations. */
+template <class ModelTy>
+class linearizability_checker
+{
+public:
+    linearizability_checker(const std::vector<operation>& ops, size_t capacity):
+        _ops(ops),
+        _capacity{ capacity }
+    {
+    }
+    bool check()
+    {
+        std::deque<uint64_t> state;
+        return _search(0, state);
+    }
+private:
+    bool _search(uint64_t done, std::deque<uint64_t>& state)
+    {
+        if (done == _all())
+            return state.empty();
+        if (!_visited.insert(std::make_pair(done, state)).second)
+            return false;
+        // Only an operation which was invoked before every pending operation responded can come next
+        uint64_t horizon = UINT64_MAX;
+        for (size_t i = 0; i < _ops.size(); ++i)
+        {
+            if (!(done & (1ull << i)) && _ops[i].response < horizon)
+                horizon = _ops[i].response;
+        }
+        for (size_t i = 0; i < _ops.size(); ++i)
+        {
+            const operation& op = _ops[i];
+            if ((done & (1ull << i)) || op.invoke > horizon)
+                continue;
+            const uint64_t next = done | (1ull << i);
+            if (!op.ok)
+            {
+                if (_search(next, state))
+                    return true;
+            }
+            else if (op.push)
+            {
+                if (state.size() >= _capacity)
+                    continue;
+                state.push_back(op.value);
+                const bool found = _search(next, state);
+                state.pop_back();
+                if (found)
+                    return true;
+            }
+            else
+            {
+                if (state.empty() || ModelTy::peek(state) != op.value)
+                    continue;
+                ModelTy::remove(state);
+                const bool found = _search(next, state);
+                ModelTy::restore(state, op.value);
+                if (found)
+                    return true;
+            }
+        }
+        return false;
+    }
+    uint64_t _all() const
+    {
+        return (_ops.size() == 64) ? UINT64_MAX : ((1ull << _ops.size()) - 1);
+    }
+
+    const std::vector<operation>& _ops;
+    const size_t _capacity;
+    std::set<std::pair<uint64_t, std::deque<uint64_t>>> _visited;
+};
+
+template <class ModelTy>
+bool linearizable(const std::vector<operation>& ops, size_t capacity)
+{
+    return linearizability_checker<ModelTy>(ops, capacity).check();
+}
+
+inline void print_history(const std::vector<operation>& ops)
+{
+    for (auto& it : ops)
+    {
+        printf("    [%3llu, %3llu] thread %u %s(%llx) -> %s\n",
+               (unsigned long long)it.invoke, (unsigned long long)it.response, (unsigned)it.thread,
+               it.push ? "push" : "pop", (unsigned long long)it.value, it.ok ? "ok" : (it.push ? "full" : "empty"));
+    }
+}
+
+} // !namespace stress_test
+
+#endif // !_VEE_SAMPLES_LOCKFREE_STRESS_CHECKER_H_
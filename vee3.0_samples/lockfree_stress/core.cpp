@@ -0,0 +1,313 @@
+#include "checker.h"
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/stack.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+namespace stress_test {
+
+namespace {
+
+using steady_t = std::chrono::steady_clock;
+
+struct options_t
+{
+    double seconds = 2.0; // per container
+    size_t threads = 4;   // the thread count of a multi side in the volume runs
+    size_t items = 1 << 14; // per producer in the volume runs
+    uint32_t seed = 0;
+};
+
+// The containers under test behind one push and pop, and the order which they promise
+template <class QueueTy>
+struct queue_target
+{
+    using model_t = fifo_model;
+    using policy_t = typename QueueTy::policy_t;
+    explicit queue_target(size_t capacity):
+        q{ capacity }
+    {
+    }
+    bool push(uint64_t value)
+    {
+        return q.enqueue(value);
+    }
+    bool pop(uint64_t& out)
+    {
+        return q.dequeue(out);
+    }
+    size_t capacity() const
+    {
+        return q.capacity;
+    }
+    QueueTy q;
+};
+
+template <class StackTy>
+struct stack_target
+{
+    using model_t = lifo_model;
+    using policy_t = typename StackTy::policy_t;
+    explicit stack_target(size_t capacity):
+        s{ capacity }
+    {
+    }
+    bool push(uint64_t value)
+    {
+        return s.push(value);
+    }
+    bool pop(uint64_t& out)
+    {
+        return s.pop(out);
+    }
+    size_t capacity() const
+    {
+        return s.capacity;
+    }
+    StackTy s;
+};
+
+template <class StartFn>
+void run_threads(size_t count, StartFn&& fn)
+{
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            fn(i);
+        });
+    }
+    go.store(true, std::memory_order_release);
+    for (auto& it : threads)
+        it.join();
+}
+
+/* Every producer pushes a numbered sequence through a small container, the consumers check that every item
+   comes out exactly once, and for a queue that the items of a producer come out of a consumer in order.
+   A lost item stops the consumers at the deadline instead of hanging the run. */
+template <class TargetTy>
+size_t run_volume(const options_t& opt, size_t capacity, steady_t::time_point deadline)
+{
+    using policy_t = typename TargetTy::policy_t;
+    const bool fifo = std::is_same<typename TargetTy::model_t, fifo_model>::value;
+    const size_t producers = policy_t::multi_producer ? opt.threads : 1;
+    const size_t consumers = policy_t::multi_consumer ? opt.threads : 1;
+    const size_t total = producers * opt.items;
+    TargetTy target{ capacity };
+    std::vector<std::atomic<uint8_t>> seen(total);
+    for (auto& it : seen)
+        it.store(0, std::memory_order_relaxed);
+    std::atomic<size_t> consumed{ 0 };
+    std::atomic<size_t> errors{ 0 };
+    auto report = [&](const char* what, uint64_t value)
+    {
+        if (errors.fetch_add(1) < 8)
+            printf("    %s: producer %u item %u\n", what, (unsigned)(value >> 32), (unsigned)(value & 0xFFFFFFFF));
+    };
+    run_threads(producers + consumers, [&](size_t id)
+    {
+        if (id < producers)
+        {
+            for (uint64_t i = 0; i < opt.items; ++i)
+            {
+                while (!target.push((static_cast<uint64_t>(id) << 32) | i))
+                {
+                    if (steady_t::now() > deadline)
+                        return;
+                    std::this_thread::yield();
+                }
+            }
+            return;
+        }
+        std::vector<int64_t> last(producers, -1);
+        uint64_t value = 0;
+        while (consumed.load(std::memory_order_relaxed) < total)
+        {
+            if (!target.pop(value))
+            {
+                if (steady_t::now() > deadline)
+                    return;
+                std::this_thread::yield();
+                continue;
+            }
+            const size_t producer = static_cast<size_t>(value >> 32);
+            const int64_t item = static_cast<int64_t>(value & 0xFFFFFFFF);
+            if (producer >= producers || item >= static_cast<int64_t>(opt.items))
+            {
+                report("corrupted", value);
+                continue;
+            }
+            if (seen[producer * opt.items + item].fetch_add(1, std::memory_order_relaxed) != 0)
+                report("duplicated", value);
+            if (fifo && item <= last[producer])
+                report("out of order", value);
+            last[producer] = item;
+            consumed.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (size_t i = 0; i < total; ++i)
+    {
+        if (seen[i].load(std::memory_order_relaxed) == 0)
+            report("lost", ((i / opt.items) << 32) | (i % opt.items));
+    }
+    uint64_t value = 0;
+    while (target.pop(value))
+        report("left over", value);
+    return errors.load();
+}
+
+/* A round runs a few threads with a few operations each on a container of capacity 1 to 3, then one thread drains it.
+   The small histories are exhaustively checked against the model, the drain catches the lost items. */
+template <class TargetTy>
+size_t run_round(std::mt19937& rng)
+{
+    using policy_t = typename TargetTy::policy_t;
+    const size_t ops_per_thread = 4;
+    const bool mixed = policy_t::multi_producer && policy_t::multi_consumer;
+    const size_t producers = policy_t::multi_producer ? 2 : 1;
+    const size_t consumers = policy_t::multi_consumer ? 2 : 1;
+    const size_t threads = mixed ? 3 : producers + consumers;
+    TargetTy target{ 1 + rng() % 3 };
+    history h{ threads + 1 };
+    std::vector<uint32_t> seeds;
+    for (size_t i = 0; i < threads; ++i)
+        seeds.push_back(rng());
+    run_threads(threads, [&](size_t id)
+    {
+        std::minstd_rand local{ seeds[id] };
+        for (size_t k = 0; k < ops_per_thread; ++k)
+        {
+            const bool push = mixed ? ((local() & 1) == 0) : (id < producers);
+            if (push)
+            {
+                const uint64_t value = ((id + 1) << 16) | k;
+                const uint64_t invoke = h.begin();
+                const bool ok = target.push(value);
+                h.end(id, invoke, true, ok, value);
+            }
+            else
+            {
+                uint64_t value = 0;
+                const uint64_t invoke = h.begin();
+                const bool ok = target.pop(value);
+                h.end(id, invoke, false, ok, ok ? value : 0);
+            }
+        }
+    });
+    for (;;)
+    {
+        uint64_t value = 0;
+        const uint64_t invoke = h.begin();
+        const bool ok = target.pop(value);
+        if (!ok)
+            break;
+        h.end(threads, invoke, false, true, value);
+    }
+    const std::vector<operation> ops = h.merge();
+    if (linearizable<typename TargetTy::model_t>(ops, target.capacity()))
+        return 0;
+    printf("    not linearizable as %s, capacity %u:\n", TargetTy::model_t::name(), (unsigned)target.capacity());
+    print_history(ops);
+    return 1;
+}
+
+template <class TargetTy>
+size_t run_target(const options_t& opt, const char* name)
+{
+    const auto started = steady_t::now();
+    const auto budget = std::chrono::duration_cast<steady_t::duration>(std::chrono::duration<double>(opt.seconds));
+    const auto volume_end = started + budget / 2;
+    const auto rounds_end = started + budget;
+    // A lost item makes a volume run wait for its deadline, which is generous so that a slow box does not fail
+    const auto hang_deadline = rounds_end + std::chrono::seconds(30);
+    const size_t max_errors = 8;
+    size_t errors = 0, volumes = 0, rounds = 0;
+    const size_t capacities[] = { 2, 7, 64 };
+    while (errors < max_errors && (volumes == 0 || steady_t::now() < volume_end))
+    {
+        errors += run_volume<TargetTy>(opt, capacities[volumes % 3], hang_deadline);
+        ++volumes;
+    }
+    std::mt19937 rng{ opt.seed ^ static_cast<uint32_t>(std::hash<std::string>()(name)) };
+    while (errors < max_errors && (rounds == 0 || steady_t::now() < rounds_end))
+    {
+        errors += run_round<TargetTy>(rng);
+        ++rounds;
+    }
+    printf("%-40s %4u volume runs, %7u histories: %s\n", name, (unsigned)volumes, (unsigned)rounds, errors ? "FAILED" : "ok");
+    fflush(stdout);
+    return errors;
+}
+
+bool parse(int argc, char* argv[], options_t& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        if (value == nullptr)
+            return false;
+        ++value;
+        if (strncmp(arg, "--seconds=", 10) == 0)
+            opt.seconds = strtod(value, nullptr);
+        else if (strncmp(arg, "--threads=", 10) == 0)
+            opt.threads = static_cast<size_t>(strtoull(value, nullptr, 10));
+        else if (strncmp(arg, "--items=", 8) == 0)
+            opt.items = static_cast<size_t>(strtoull(value, nullptr, 10));
+        else if (strncmp(arg, "--seed=", 7) == 0)
+            opt.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else
+            return false;
+    }
+    return opt.seconds > 0 && opt.threads > 0 && opt.items > 0 && opt.items <= 0xFFFFFFFF;
+}
+
+} // !unnamed namespace
+
+} // !namespace stress_test
+
+/* usage: lockfree_stress [--seconds=N] [--threads=N] [--items=N] [--seed=N]
+   Hammers every lockfree container for the given seconds with the random delays of vee/lockfree/stress.h,
+   half of the time with high-volume runs(no loss, no duplicate, per-producer FIFO) and half with small histories
+   checked for linearizability. Exits with 1 on the first container which fails, a failing seed reproduces
+   the same operation mix, while the interleaving still depends on the scheduler. */
+int main(int argc, char* argv[])
+{
+    using namespace vee::lockfree;
+    stress_test::options_t opt;
+    opt.seed = static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    if (!stress_test::parse(argc, argv, opt))
+    {
+        fprintf(stderr, "usage: lockfree_stress [--seconds=N] [--threads=N] [--items=N] [--seed=N]\n");
+        return 1;
+    }
+#if !VEE_LOCKFREE_STRESS
+    printf("warning: built without VEE_LOCKFREE_STRESS, the delay injection is off\n");
+#endif
+    printf("seed %u\n", (unsigned)opt.seed);
+    stress::global_seed().store(opt.seed);
+    size_t errors = 0;
+    errors += stress_test::run_target<stress_test::queue_target<atqueue<uint64_t, property::mpmc>>>(opt, "atqueue<mpmc>");
+    errors += stress_test::run_target<stress_test::queue_target<atqueue<uint64_t, property::mpsc>>>(opt, "atqueue<mpsc>");
+    errors += stress_test::run_target<stress_test::queue_target<atqueue<uint64_t, property::spmc>>>(opt, "atqueue<spmc>");
+    errors += stress_test::run_target<stress_test::queue_target<atqueue<uint64_t, property::spsc>>>(opt, "atqueue<spsc>");
+    errors += stress_test::run_target<stress_test::queue_target<atqueue<uint64_t, property::mpmc, property::pow2_capacity>>>(opt, "atqueue<mpmc, pow2_capacity>");
+    errors += stress_test::run_target<stress_test::queue_target<queue<uint64_t, property::mpmc>>>(opt, "queue<mpmc>");
+    errors += stress_test::run_target<stress_test::stack_target<stack<uint64_t, property::mpmc>>>(opt, "stack<mpmc>");
+    errors += stress_test::run_target<stress_test::stack_target<stack<uint64_t, property::spmc>>>(opt, "stack<spmc>");
+    errors += stress_test::run_target<stress_test::stack_target<stack<uint64_t, property::mpmc, 4>>>(opt, "stack<mpmc, 4 elimination slots>");
+    return errors ? 1 : 0;
+}
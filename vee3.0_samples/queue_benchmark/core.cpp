@@ -0,0 +1,280 @@
+#include "queues.h"
+#include <vee/test/timerec.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace bench {
+
+namespace {
+
+struct options_t
+{
+    size_t items = 1 << 18;
+    size_t threads = 4; // the thread count of a multi side
+    bool json = false;
+    std::vector<std::string> queues{ "atqueue", "lockfree_queue", "lockfree_stack", "vee_queue", "mutex_deque" };
+    std::vector<std::string> configs{ "spsc", "mpsc", "spmc", "mpmc" };
+    std::vector<size_t> payloads{ 8, 64, 256 };
+    std::vector<size_t> capacities{ 64, 1024, 65536, 1 << 20 };
+
+    bool selected(const char* queue) const
+    {
+        return std::find(queues.begin(), queues.end(), queue) != queues.end();
+    }
+};
+
+struct result_t
+{
+    const char* queue;
+    const char* config;
+    size_t producers;
+    size_t consumers;
+    size_t payload;
+    size_t capacity;
+    size_t items;
+    double seconds;
+    int64_t p50_ns;
+    int64_t p99_ns;
+    int64_t p999_ns;
+};
+
+inline int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t percentile(std::vector<int64_t>& samples, double ratio)
+{
+    if (samples.empty())
+        return 0;
+    auto nth = samples.begin() + static_cast<ptrdiff_t>(ratio * (samples.size() - 1));
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+void print_header(const options_t& opt)
+{
+    if (!opt.json)
+        printf("queue,config,producers,consumers,payload_bytes,capacity,items,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns\n");
+}
+
+void print_result(const options_t& opt, const result_t& r)
+{
+    const double ops = r.items / r.seconds;
+    if (opt.json)
+    {
+        printf("{\"queue\":\"%s\",\"config\":\"%s\",\"producers\":%u,\"consumers\":%u,\"payload_bytes\":%u,\"capacity\":%u,"
+               "\"items\":%u,\"seconds\":%.6f,\"ops_per_sec\":%.0f,\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld}\n",
+               r.queue, r.config, (unsigned)r.producers, (unsigned)r.consumers, (unsigned)r.payload, (unsigned)r.capacity,
+               (unsigned)r.items, r.seconds, ops, (long long)r.p50_ns, (long long)r.p99_ns, (long long)r.p999_ns);
+    }
+    else
+    {
+        printf("%s,%s,%u,%u,%u,%u,%u,%.6f,%.0f,%lld,%lld,%lld\n",
+               r.queue, r.config, (unsigned)r.producers, (unsigned)r.consumers, (unsigned)r.payload, (unsigned)r.capacity,
+               (unsigned)r.items, r.seconds, ops, (long long)r.p50_ns, (long long)r.p99_ns, (long long)r.p999_ns);
+    }
+    fflush(stdout);
+}
+
+// The producers stamp every item, and the consumers record the time from the stamp to the pop
+template <class AdapterTy, class PayloadTy>
+void run_case(const options_t& opt, const char* config, size_t producers, size_t consumers, size_t capacity)
+{
+    AdapterTy q{ capacity };
+    const size_t per_producer = opt.items / producers;
+    const size_t total = per_producer * producers;
+    std::atomic<size_t> consumed{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::vector<int64_t>> latencies(consumers);
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&]()
+        {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            PayloadTy item{};
+            for (size_t i = 0; i < per_producer; ++i)
+            {
+                item.stamp = now_ns();
+                while (!q.push(item))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&, c]()
+        {
+            std::vector<int64_t>& samples = latencies[c];
+            samples.reserve(total / consumers);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            PayloadTy item;
+            while (consumed.load(std::memory_order_relaxed) < total)
+            {
+                if (q.pop(item))
+                {
+                    samples.push_back(now_ns() - item.stamp);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+    vee::test::timerec rec;
+    go.store(true, std::memory_order_release);
+    for (auto& it : threads)
+        it.join();
+    const double seconds = rec.timelab().second;
+
+    std::vector<int64_t> samples;
+    samples.reserve(total);
+    for (auto& it : latencies)
+        samples.insert(samples.end(), it.begin(), it.end());
+    result_t r{ AdapterTy::name(), config, producers, consumers, sizeof(PayloadTy), capacity, total, seconds, 0, 0, 0 };
+    r.p50_ns = percentile(samples, 0.5);
+    r.p99_ns = percentile(samples, 0.99);
+    r.p999_ns = percentile(samples, 0.999);
+    print_result(opt, r);
+}
+
+template <class PayloadTy, class PolicyTy>
+void run_queues(const options_t& opt, const char* config, size_t producers, size_t consumers, size_t capacity)
+{
+    if (opt.selected(atqueue_adapter<PayloadTy, PolicyTy>::name()))
+        run_case<atqueue_adapter<PayloadTy, PolicyTy>, PayloadTy>(opt, config, producers, consumers, capacity);
+    if (opt.selected(lockfree_queue_adapter<PayloadTy, PolicyTy>::name()))
+        run_case<lockfree_queue_adapter<PayloadTy, PolicyTy>, PayloadTy>(opt, config, producers, consumers, capacity);
+    if (opt.selected(lockfree_stack_adapter<PayloadTy, PolicyTy>::name()))
+        run_case<lockfree_stack_adapter<PayloadTy, PolicyTy>, PayloadTy>(opt, config, producers, consumers, capacity);
+    if (opt.selected(vee_queue_adapter<PayloadTy, PolicyTy>::name()))
+        run_case<vee_queue_adapter<PayloadTy, PolicyTy>, PayloadTy>(opt, config, producers, consumers, capacity);
+    if (opt.selected(mutex_deque_adapter<PayloadTy, PolicyTy>::name()))
+        run_case<mutex_deque_adapter<PayloadTy, PolicyTy>, PayloadTy>(opt, config, producers, consumers, capacity);
+}
+
+template <class PolicyTy>
+void run_config(const options_t& opt, const char* config)
+{
+    const size_t producers = (PolicyTy::multi_producer) ? opt.threads : 1;
+    const size_t consumers = (PolicyTy::multi_consumer) ? opt.threads : 1;
+    for (size_t payload : opt.payloads)
+    {
+        for (size_t capacity : opt.capacities)
+        {
+            switch (payload)
+            {
+            case 8: run_queues<payload_t<8>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            case 16: run_queues<payload_t<16>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            case 32: run_queues<payload_t<32>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            case 64: run_queues<payload_t<64>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            case 128: run_queues<payload_t<128>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            case 256: run_queues<payload_t<256>, PolicyTy>(opt, config, producers, consumers, capacity); break;
+            default: fprintf(stderr, "unsupported payload size: %u\n", (unsigned)payload); return;
+            }
+        }
+    }
+}
+
+std::vector<std::string> split(const char* list)
+{
+    std::vector<std::string> result;
+    std::string item;
+    for (const char* it = list; ; ++it)
+    {
+        if (*it == ',' || *it == '\0')
+        {
+            if (!item.empty())
+                result.push_back(item);
+            item.clear();
+            if (*it == '\0')
+                break;
+        }
+        else
+            item.push_back(*it);
+    }
+    return result;
+}
+
+std::vector<size_t> split_numbers(const char* list)
+{
+    std::vector<size_t> result;
+    for (auto& it : split(list))
+        result.push_back(static_cast<size_t>(strtoull(it.c_str(), nullptr, 10)));
+    return result;
+}
+
+bool parse(int argc, char* argv[], options_t& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        if (value == nullptr)
+            return false;
+        ++value;
+        if (strncmp(arg, "--items=", 8) == 0)
+            opt.items = static_cast<size_t>(strtoull(value, nullptr, 10));
+        else if (strncmp(arg, "--threads=", 10) == 0)
+            opt.threads = static_cast<size_t>(strtoull(value, nullptr, 10));
+        else if (strncmp(arg, "--format=", 9) == 0)
+            opt.json = (strcmp(value, "json") == 0);
+        else if (strncmp(arg, "--queues=", 9) == 0)
+            opt.queues = split(value);
+        else if (strncmp(arg, "--configs=", 10) == 0)
+            opt.configs = split(value);
+        else if (strncmp(arg, "--payloads=", 11) == 0)
+            opt.payloads = split_numbers(value);
+        else if (strncmp(arg, "--capacities=", 13) == 0)
+            opt.capacities = split_numbers(value);
+        else
+            return false;
+    }
+    return opt.items > 0 && opt.threads > 0;
+}
+
+} // !unnamed namespace
+
+} // !namespace bench
+
+/* usage: queue_benchmark [--items=N] [--threads=N] [--format=csv|json]
+                          [--queues=atqueue,lockfree_queue,lockfree_stack,vee_queue,mutex_deque]
+                          [--configs=spsc,mpsc,spmc,mpmc] [--payloads=8,16,32,64,128,256] [--capacities=64,1024,...]
+   Prints one CSV row (or one JSON object per line) for every combination, the latencies are in nanoseconds.
+   The producers run flat out, so a large capacity lets the items wait in the queue and the latency includes that wait. */
+int main(int argc, char* argv[])
+{
+    using namespace vee::lockfree;
+    bench::options_t opt;
+    if (!bench::parse(argc, argv, opt))
+    {
+        fprintf(stderr, "usage: queue_benchmark [--items=N] [--threads=N] [--format=csv|json] [--queues=...] [--configs=...] [--payloads=...] [--capacities=...]\n");
+        return 1;
+    }
+    bench::print_header(opt);
+    for (auto& config : opt.configs)
+    {
+        if (config == "spsc")
+            bench::run_config<property::spsc>(opt, "spsc");
+        else if (config == "mpsc")
+            bench::run_config<property::mpsc>(opt, "mpsc");
+        else if (config == "spmc")
+            bench::run_config<property::spmc>(opt, "spmc");
+        else if (config == "mpmc")
+            bench::run_config<property::mpmc>(opt, "mpmc");
+        else
+            fprintf(stderr, "unknown config: %s\n", config.c_str());
+    }
+    return 0;
+}
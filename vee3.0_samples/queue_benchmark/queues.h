@@ -0,0 +1,164 @@
+#ifndef _VEE_SAMPLES_QUEUE_BENCHMARK_QUEUES_H_
+#define _VEE_SAMPLES_QUEUE_BENCHMARK_QUEUES_H_
+
+#include <vee/lockfree/queue.h>
+#include <vee/lockfree/stack.h>
+#include <vee/queue.h>
+#include <vee/lock.h>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+namespace bench {
+
+// A message of the given size, the producer stamps it so that the consumer can measure the handoff latency
+template <size_t Bytes>
+struct payload_t
+{
+    int64_t stamp;
+    char fill[Bytes - sizeof(int64_t)];
+};
+
+template <>
+struct payload_t<sizeof(int64_t)>
+{
+    int64_t stamp;
+};
+
+// Every adapter offers a non-blocking push and pop, the policy is ignored where the container has none
+template <class PayloadTy, class PolicyTy>
+class atqueue_adapter
+{
+public:
+    static const char* name()
+    {
+        return "atqueue";
+    }
+    explicit atqueue_adapter(size_t capacity):
+        _q{ capacity }
+    {
+    }
+    bool push(const PayloadTy& value)
+    {
+        return _q.enqueue(value);
+    }
+    bool pop(PayloadTy& out)
+    {
+        return _q.dequeue(out);
+    }
+private:
+    vee::lockfree::atqueue<PayloadTy, PolicyTy> _q;
+};
+
+template <class PayloadTy, class PolicyTy>
+class lockfree_queue_adapter
+{
+public:
+    static const char* name()
+    {
+        return "lockfree_queue";
+    }
+    explicit lockfree_queue_adapter(size_t capacity):
+        _q{ capacity }
+    {
+    }
+    bool push(const PayloadTy& value)
+    {
+        return _q.enqueue(value);
+    }
+    bool pop(PayloadTy& out)
+    {
+        return _q.dequeue(out);
+    }
+private:
+    vee::lockfree::queue<PayloadTy, PolicyTy> _q;
+};
+
+// LIFO, so its latency tail is expected to be long whenever the stack is not drained at once
+template <class PayloadTy, class PolicyTy>
+class lockfree_stack_adapter
+{
+public:
+    static const char* name()
+    {
+        return "lockfree_stack";
+    }
+    explicit lockfree_stack_adapter(size_t capacity):
+        _s{ capacity }
+    {
+    }
+    bool push(const PayloadTy& value)
+    {
+        return _s.push(value);
+    }
+    bool pop(PayloadTy& out)
+    {
+        return _s.pop(out);
+    }
+private:
+    vee::lockfree::stack<PayloadTy, PolicyTy> _s;
+};
+
+template <class PayloadTy, class PolicyTy>
+class vee_queue_adapter
+{
+public:
+    static const char* name()
+    {
+        return "vee_queue";
+    }
+    explicit vee_queue_adapter(size_t capacity):
+        _q{ capacity }
+    {
+    }
+    bool push(const PayloadTy& value)
+    {
+        return _q.enqueue(value);
+    }
+    bool pop(PayloadTy& out)
+    {
+        return _q.dequeue(out);
+    }
+private:
+    vee::queue<PayloadTy, vee::lock::spin_lock, vee::lock::spin_lock> _q;
+};
+
+// Baseline: a bounded std::deque behind a std::mutex
+template <class PayloadTy, class PolicyTy>
+class mutex_deque_adapter
+{
+public:
+    static const char* name()
+    {
+        return "mutex_deque";
+    }
+    explicit mutex_deque_adapter(size_t capacity):
+        _capacity{ capacity }
+    {
+    }
+    bool push(const PayloadTy& value)
+    {
+        std::lock_guard<std::mutex> locker{ _lock };
+        if (_q.size() == _capacity)
+            return false;
+        _q.push_back(value);
+        return true;
+    }
+    bool pop(PayloadTy& out)
+    {
+        std::lock_guard<std::mutex> locker{ _lock };
+        if (_q.empty())
+            return false;
+        out = _q.front();
+        _q.pop_front();
+        return true;
+    }
+private:
+    const size_t _capacity;
+    std::mutex _lock;
+    std::deque<PayloadTy> _q;
+};
+
+} // !namespace bench
+
+#endif // !_VEE_SAMPLES_QUEUE_BENCHMARK_QUEUES_H_
@@ -1,7 +1,13 @@
-#include <iostream>
+#include <vee/libtest.h>
+using namespace vee;
 
 int main()
 {
-    printf("Hello World!\n");
-    return 0;
-}
\ No newline at end of file
+    libtest::test_lockfree test_lockfree;
+    size_t error = test_lockfree.test_all();
+    printf("lockfree errors: %u\n", static_cast<unsigned>(error));
+    libtest::test_lock test_lock;
+    size_t lock_error = test_lock.test_all();
+    printf("lock errors: %u\n", static_cast<unsigned>(lock_error));
+    return (error + lock_error) ? 1 : 0;
+}